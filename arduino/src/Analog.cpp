@@ -2,11 +2,30 @@
 #include "clocks.h"
 #include "GPIO.h"
 #include "atomic.h"
+#include "sleep.h"
+#include "EventSystem.h"
 
 #define BAND_GAP_MV 1100
 
+// Generic clock generator used to keep the ADC clocked in standby
+#define ADC_STANDBY_GCLK GCLK_GENDIV_ID_GCLK3_Val
+
 int32_t _ctrlB;
 
+// Event triggered conversion state, results are collected in ADC_Handler
+static volatile int16_t *_trigBuffer = NULL;
+static volatile uint16_t _trigLen = 0;
+static volatile uint16_t _trigNdx = 0;
+static volatile uint8_t  _trigReady = 0;
+static volatile uint8_t  _trigDiscard = 0;
+static int8_t            _trigEventChannel = -1;
+static uint32_t          _trigPreScaler = ana_clk_div_8;
+static void ( *_trigCallback )( volatile int16_t *, uint16_t ) = NULL;
+
+// Window monitor state
+static int8_t  _winEventChannel = -1;
+static void ( *_winCallback )( int16_t ) = NULL;
+
 // ADC register synchronization macros
 #define ADC_SYNC_BUSY ( ADC->STATUS.bit.SYNCBUSY )
 #define ADC_WAIT_SYNC while( ADC_SYNC_BUSY )
@@ -17,7 +36,8 @@ int32_t _ctrlB;
     ADC->REFCTRL.reg |= x;
 
 // Sets the number of samples to accumulate and average for the ADC and
-// corresponding configuration bits
+// corresponding configuration bits. The result is always the 12 bit average,
+// use readAccumulated() for results with more bits
 #define ADC_SET_SAMPLE_ACCUM( x )                       \
     {                                                   \
         ADC->AVGCTRL.reg = 0;                           \
@@ -44,6 +64,9 @@ int32_t _ctrlB;
     _ctrlB &= ~ADC_CTRLB_PRESCALER_Msk; \
     _ctrlB |= x;
 
+// Fastest ADC clock, from the ADC electrical characteristics
+#define ADC_MAX_CLK_HZ 2100000ul
+
 // Bring up ADC
 #define BRING_UP_ADC                                                       \
     enableAPBCClk( PM_APBCMASK_ADC, 1 );                                   \
@@ -67,10 +90,26 @@ int32_t _ctrlB;
     disableGenericClk( GCLK_CLKCTRL_ID_ADC_Val ); \
     enableAPBCClk( PM_APBCMASK_ADC, 0 );
 
+// ADC clocks per conversion, sampling time is (SAMPLEN + 1) half ADC clocks
+// plus a propagation delay of 7 ADC clocks for a 12 bit conversion
+#define ADC_CONVERSION_CLKS ( ( ( ADC_SAMPCTRL_MASK + 1 ) / 2 ) + 7 )
+
 // DAC register synchronization macros
 #define DAC_SYNC_BUSY ( DAC->STATUS.bit.SYNCBUSY )
 #define DAC_WAIT_SYNC while( DAC_SYNC_BUSY )
 
+// The prescaler divides the main clock (GCLK0), so a prescaler picked for
+// 8 MHz overclocks the ADC at 48 MHz. Divides further when pre would run the
+// ADC above ADC_MAX_CLK_HZ at the current SystemCoreClock.
+static uint32_t adcPrescaler( uint32_t pre )
+{
+    while( pre < ana_clk_div_512 &&
+           SystemCoreClock / ( 4UL << ( pre >> ADC_CTRLB_PRESCALER_Pos ) ) >
+               ADC_MAX_CLK_HZ )
+        pre += ( 1UL << ADC_CTRLB_PRESCALER_Pos );
+    return pre;
+}
+
 int16_t singleShotConversion()
 {
     // The first conversion after the reference is changed must not be used.
@@ -115,7 +154,7 @@ int16_t Analog::readSingle()
     // Configure the read parameters
     ADC_SET_REF( _settings._ref );
     ADC_SET_RESOLUTION( _settings._resolution );
-    ADC_SET_PRESCALER( _settings._preScaler );
+    ADC_SET_PRESCALER( adcPrescaler( _settings._preScaler ) );
     ADC_SET_SAMPLE_ACCUM( _settings._accum );
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
@@ -151,6 +190,147 @@ int16_t Analog::readSingle( AnalogSettings settings )
     return readSingle();
 }
 
+// Splits the right shift that brings a sum of 2^accum 12 bit samples down to
+// resultBits between the ADC and software. The ADC truncates sums wider than 16
+// bits on its own (accum - 4 bits), ADJRES can shift a further 4 bits, the
+// rest is done in software. A negative software shift is a left shift.
+static void oversampleShifts( uint8_t accum, uint8_t resultBits,
+                              uint8_t *adjRes, int8_t *swShift )
+{
+    int8_t total = ( 12 + accum ) - resultBits;
+    int8_t autoShift = ( accum > 4 ) ? ( accum - 4 ) : 0;
+    int8_t remaining = total - autoShift;
+
+    *adjRes = ( remaining > 4 ) ? 4 : ( ( remaining < 0 ) ? 0 : remaining );
+    *swShift = remaining - *adjRes;
+}
+
+int32_t Analog::readAccumulated( AnalogAccum_t accum, uint8_t resultBits )
+{
+    uint8_t adjRes;
+    int8_t  swShift;
+    int32_t val;
+
+    // Ensure the positive input channel is actually an analog channel
+    if( _posChannel == -1 ) return -1;
+    if( resultBits < 12 || resultBits > 16 ) return -1;
+    if( accum > ana_accum_1024 ) return -1;
+
+    oversampleShifts( accum, resultBits, &adjRes, &swShift );
+
+    BRING_UP_ADC
+
+    // Configure input pins, if using dual-ended input configure for
+    // differential mode
+    pinMode( _posInputPin, gArduinoPins[_posInputPin].analog );
+    if( _negInputPin != -1 ) {
+        pinMode( _negInputPin, gArduinoPins[_negInputPin].analog );
+        _ctrlB |= ADC_CTRLB_DIFFMODE;
+    }
+
+    // Configure the read parameters, start with a single 12 bit conversion
+    ADC_SET_REF( _settings._ref );
+    ADC_SET_RESOLUTION( ana_resolution_12bit );
+    ADC_SET_PRESCALER( adcPrescaler( _settings._preScaler ) );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLB.reg = _ctrlB;
+    } )
+
+    // Configure the gain, sample length (fixed), and the input channels
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_MASK; // 64 ADC clock cycles
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->INPUTCTRL.reg = _settings._gain |
+                             ADC_INPUTCTRL_MUXPOS( _posChannel ) |
+                             ADC_INPUTCTRL_MUXNEG( _negChannel );
+    } )
+
+    // The first conversion after the reference is changed must not be used,
+    // throw away a single conversion rather than a whole accumulation
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 1;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->SWTRIG.bit.START = 1;
+    } )
+    while( !ADC->INTFLAG.bit.RESRDY )
+        ;
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        val = ADC->RESULT.reg;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 0;
+    } )
+
+    // Now accumulate into the 16 bit result register
+    ADC_SET_RESOLUTION( ADC_CTRLB_RESSEL_16BIT );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLB.reg = _ctrlB;
+    } )
+    ADC->AVGCTRL.reg =
+        ADC_AVGCTRL_SAMPLENUM( accum ) | ADC_AVGCTRL_ADJRES( adjRes );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 1;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->SWTRIG.bit.START = 1;
+    } )
+    while( !ADC->INTFLAG.bit.RESRDY )
+        ;
+
+    // Differential results are signed
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        if( _negInputPin != -1 )
+            val = (int16_t)ADC->RESULT.reg;
+        else
+            val = (uint16_t)ADC->RESULT.reg;
+    } )
+
+    // Disable the peripheral to save power
+    TAKE_DOWN_ADC
+
+    if( swShift > 0 )
+        val >>= swShift;
+    else if( swShift < 0 )
+        val <<= -swShift;
+
+    return val;
+}
+
+int32_t Analog::readOversampled( AnalogOversample_t bits )
+{
+    uint8_t resultBits = 12;
+    switch( bits ) {
+        case ana_oversample_13bit: resultBits = 13; break;
+        case ana_oversample_14bit: resultBits = 14; break;
+        case ana_oversample_15bit: resultBits = 15; break;
+        case ana_oversample_16bit: resultBits = 16; break;
+    }
+
+    return readAccumulated( (AnalogAccum_t)bits, resultBits );
+}
+
+// Returns the conversion latency in micro seconds of an accumulated read at the
+// current SystemCoreClock, including the discarded first conversion and any
+// extra division adcPrescaler() applies
+uint32_t Analog::getAccumulatedLatency( AnalogAccum_t     accum,
+                                        AnalogPrescaler_t pre )
+{
+    uint64_t clks = ( ( 1UL << accum ) + 1 ) * ADC_CONVERSION_CLKS;
+    clks *= ( 4UL << ( adcPrescaler( pre ) >> ADC_CTRLB_PRESCALER_Pos ) );
+
+    return ( uint32_t )( ( clks * 1000000 ) / SystemCoreClock );
+}
+
 void Analog::writeSingle( int16_t val, bool outputInternal )
 {
     // TODO: perhaps handle pins that aren't the DAC output pin
@@ -186,78 +366,267 @@ void Analog::writeSingle( int16_t val, bool outputInternal )
     } )
 }
 
-int16_t Analog::readVCC()
+// Converts len consecutive AIN channels starting at firstChannel with a single
+// free running trigger. INPUTOFFSET walks the channels in order and wraps back
+// to zero, so the first (unusable) result is discarded and one extra
+// conversion picks up offset zero again.
+static int8_t scanConversion( int32_t firstChannel, uint8_t len,
+                              int16_t *results, uint32_t gain )
+{
+    int16_t val;
+
+    // Restart the scan at offset zero
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 0;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->INPUTCTRL.reg = gain | ADC_INPUTCTRL_MUXPOS( firstChannel ) |
+                             ADC_INPUTCTRL_MUXNEG_GND |
+                             ADC_INPUTCTRL_INPUTSCAN( len - 1 ) |
+                             ADC_INPUTCTRL_INPUTOFFSET( 0 );
+    } )
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY | ADC_INTFLAG_OVERRUN;
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 1;
+    } )
+
+    // One trigger, the ADC is in free running mode from here on
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->SWTRIG.bit.START = 1;
+    } )
+
+    for( uint8_t i = 0; i <= len; i++ ) {
+        while( !ADC->INTFLAG.bit.RESRDY )
+            ;
+
+        ATOMIC_OPERATION( {
+            if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+            val = ADC->RESULT.reg;
+        } )
+
+        if( i > 0 ) results[i % len] = val;
+    }
+
+    // If a result was dropped the channel order can no longer be trusted
+    if( ADC->INTFLAG.bit.OVERRUN ) return -1;
+
+    return 0;
+}
+
+int8_t Analog::readScan( const int32_t *pins, uint8_t count, int16_t *results )
+{
+    return readScan( pins, count, results, AnalogSettings() );
+}
+
+int8_t Analog::readScan( const int32_t *pins, uint8_t count, int16_t *results,
+                         AnalogSettings settings )
+{
+    if( pins == NULL || results == NULL || count == 0 ) return -1;
+
+    // Ensure every pin is an analog channel before touching the ADC
+    for( uint8_t i = 0; i < count; i++ ) {
+        if( getPosChannel( pins[i] ) == -1 ) return -1;
+        pinMode( pins[i], gArduinoPins[pins[i]].analog );
+    }
+
+    BRING_UP_ADC
+
+    // Configure the read parameters, the scan runs in free running mode
+    ADC_SET_REF( settings._ref );
+    ADC_SET_RESOLUTION( settings._resolution );
+    ADC_SET_PRESCALER( adcPrescaler( settings._preScaler ) );
+    ADC_SET_SAMPLE_ACCUM( settings._accum );
+    _ctrlB |= ADC_CTRLB_FREERUN;
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLB.reg = _ctrlB;
+    } )
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_MASK; // 64 ADC clock cycles
+
+    // The AIN mapping on the pins is not contiguous (AIN0, AIN4 - AIN7,
+    // AIN16 - AIN19), so split the request into runs of consecutive channels
+    // and scan each run with a single trigger
+    int8_t  rtn = count;
+    uint8_t i = 0;
+    while( i < count ) {
+        int32_t first = getPosChannel( pins[i] );
+        uint8_t len = 1;
+        while( ( i + len ) < count && len < ANALOG_SCAN_MAX_CHANNELS &&
+               getPosChannel( pins[i + len] ) == ( first + len ) )
+            len++;
+
+        if( scanConversion( first, len, &results[i], settings._gain ) != 0 ) {
+            rtn = -1;
+            break;
+        }
+
+        i += len;
+    }
+
+    // Disable the peripheral to save power
+    TAKE_DOWN_ADC
+
+    return rtn;
+}
+
+// Keeps a triggered session's ADC clock in range after a CPU clock change,
+// the conversion in progress is discarded
+static void trigClockPostChange( void * )
+{
+    ADC_SET_PRESCALER( adcPrescaler( _trigPreScaler ) );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLB.reg = _ctrlB;
+        _trigDiscard = 1;
+    } )
+}
+
+int8_t Analog::beginTriggered( uint8_t eventGenerator, volatile int16_t *buffer,
+                               uint16_t len,
+                               void ( *callback )( volatile int16_t *buffer,
+                                                   uint16_t len ) )
 {
+    if( _posChannel == -1 || buffer == NULL || len == 0 ) return -1;
+
+    // Only one user can own the ADC
+    disarmWindow();
+    endTriggered();
+    _trigEventChannel = allocEventChannel();
+    if( _trigEventChannel == -1 ) return -1;
+
     BRING_UP_ADC
 
-    // Have to set the band-gap channel as an input into the ADC
-    SYSCTRL->VREF.bit.BGOUTEN = 1;
+    // Configure input pins, if using dual-ended input configure for
+    // differential mode
+    pinMode( _posInputPin, gArduinoPins[_posInputPin].analog );
+    if( _negInputPin != -1 ) {
+        pinMode( _negInputPin, gArduinoPins[_negInputPin].analog );
+        _ctrlB |= ADC_CTRLB_DIFFMODE;
+    }
 
     // Configure the read parameters
-    ADC_SET_REF( ana_ref_internal_0_5_vddana );
-    ADC_SET_RESOLUTION( ana_resolution_12bit );
-    ADC_SET_PRESCALER( ana_clk_div_8 );
-    ADC_SET_SAMPLE_ACCUM( ana_accum_64 );
+    ADC_SET_REF( _settings._ref );
+    ADC_SET_RESOLUTION( _settings._resolution );
+    ADC_SET_PRESCALER( adcPrescaler( _settings._preScaler ) );
+    ADC_SET_SAMPLE_ACCUM( _settings._accum );
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
         ADC->CTRLB.reg = _ctrlB;
     } )
+    _trigPreScaler = _settings._preScaler;
 
     // Configure the gain, sample length (fixed), and the input channels
     ADC->SAMPCTRL.reg = ADC_SAMPCTRL_MASK; // 64 ADC clock cycles
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
-        ADC->INPUTCTRL.reg = ADC_INPUTCTRL_GAIN_1X |
-                             ADC_INPUTCTRL_MUXPOS_BANDGAP |
-                             ADC_INPUTCTRL_MUXNEG_GND;
+        ADC->INPUTCTRL.reg = _settings._gain |
+                             ADC_INPUTCTRL_MUXPOS( _posChannel ) |
+                             ADC_INPUTCTRL_MUXNEG( _negChannel );
     } )
 
-    // Enable the ADC
+    // The first conversion after the reference is changed must not be used
+    _trigBuffer = buffer;
+    _trigLen = len;
+    _trigNdx = 0;
+    _trigReady = 0;
+    _trigDiscard = 1;
+    _trigCallback = callback;
+
+    // Each incoming event starts one conversion, results are collected in the
+    // result ready interrupt
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY | ADC_INTFLAG_OVERRUN;
+    ADC->INTENSET.reg = ADC_INTENSET_RESRDY;
+    NVIC_EnableIRQ( ADC_IRQn );
+
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
         ADC->CTRLA.bit.ENABLE = 1;
     } )
 
-    int16_t val = singleShotConversion();
+    // Connect the trigger last so no event arrives before the ADC is ready
+    routeEvent( _trigEventChannel, eventGenerator, event_path_async,
+                event_edge_none );
+    addEventUser( _trigEventChannel, EVENT_USER_ADC_START );
+
+    // The ADC runs from the main clock until endTriggered()
+    registerClockNotifier( NULL, trigClockPostChange, NULL );
+
+    return 0;
+}
+
+// Returns true once per filled buffer, for callers that poll instead of using
+// the callback
+bool Analog::triggeredBatchReady()
+{
+    if( !_trigReady ) return false;
+
+    _trigReady = 0;
+    return true;
+}
+
+void Analog::endTriggered()
+{
+    if( _trigEventChannel == -1 ) return;
+
+    unregisterClockNotifier( trigClockPostChange, NULL );
+    freeEventChannel( _trigEventChannel );
+    _trigEventChannel = -1;
+
+    NVIC_DisableIRQ( ADC_IRQn );
+    ADC->INTENCLR.reg = ADC_INTENCLR_RESRDY;
+    ADC->EVCTRL.reg = 0;
 
     // Disable the peripheral to save power
     TAKE_DOWN_ADC
 
-    // Take down the band gap input
-    SYSCTRL->VREF.bit.BGOUTEN = 0;
-
-    // Convert band-gap to VCC
-    int16_t vccMv = ( ( BAND_GAP_MV * 4095 ) / val ) * 2;
-    return vccMv;
+    _trigBuffer = NULL;
+    _trigCallback = NULL;
 }
 
-int16_t Analog::readTemperature()
+int8_t Analog::armWindow( int16_t lo, int16_t hi, AnalogWindowMode_t mode,
+                          void ( *callback )( int16_t result ),
+                          AnalogWindowRate_t rate )
 {
-    // Read calibration values
-    uint32_t *tempLogLow = (uint32_t *)NVMCTRL_TEMP_LOG;
-    uint32_t *tempLogHigh = (uint32_t *)( NVMCTRL_TEMP_LOG + 4 );
-    int8_t    roomTempVal =
-        ( ( *tempLogLow ) & NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Msk ) >>
-        NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Pos;
-    int8_t hotRoomTempVal =
-        ( ( *tempLogLow ) & NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Msk ) >>
-        NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Pos;
-    int16_t roomADCVal =
-        ( ( *tempLogHigh ) & NVMCTRL_FUSES_ROOM_ADC_VAL_Msk ) >>
-        NVMCTRL_FUSES_ROOM_ADC_VAL_Pos;
-    int16_t hotADCVal = ( ( *tempLogHigh ) & NVMCTRL_FUSES_HOT_ADC_VAL_Msk ) >>
-                        NVMCTRL_FUSES_HOT_ADC_VAL_Pos;
+    if( _posChannel == -1 || callback == NULL ) return -1;
+
+    // Only one user can own the ADC
+    endTriggered();
+    disarmWindow();
+    if( claimClkGenerator( ADC_STANDBY_GCLK ) != 0 ) return -1;
+    _winEventChannel = allocEventChannel();
+    if( _winEventChannel == -1 ) {
+        releaseClkGenerator( ADC_STANDBY_GCLK );
+        return -1;
+    }
 
     BRING_UP_ADC
 
-    // Have to set the temperature sensor channel as an input into the ADC
-    SYSCTRL->VREF.bit.TSEN = 1;
+    // OSC8M is stopped in standby (and disabled while running from the
+    // DFLL), hold it on demand so it only starts when the ADC requests a
+    // clock. The hold survives CPU clock changes, though moving the CPU to a
+    // divided OSC8M also slows the conversions.
+    holdOSC8MStandby();
+    initClkGenerator( GCLK_GENCTRL_SRC_OSC8M_Val, ADC_STANDBY_GCLK, 0, 1, 0 );
+    initGenericClk( GCLK_CLKCTRL_GEN_GCLK3_Val, GCLK_CLKCTRL_ID_ADC_Val );
+
+    // Configure input pins, if using dual-ended input configure for
+    // differential mode
+    pinMode( _posInputPin, gArduinoPins[_posInputPin].analog );
+    if( _negInputPin != -1 ) {
+        pinMode( _negInputPin, gArduinoPins[_negInputPin].analog );
+        _ctrlB |= ADC_CTRLB_DIFFMODE;
+    }
 
     // Configure the read parameters
-    ADC_SET_REF( ana_ref_internal_1v );
-    ADC_SET_RESOLUTION( ana_resolution_12bit );
-    ADC_SET_PRESCALER( ana_clk_div_8 );
-    ADC_SET_SAMPLE_ACCUM( ana_accum_64 );
+    ADC_SET_REF( _settings._ref );
+    ADC_SET_RESOLUTION( _settings._resolution );
+    ADC_SET_PRESCALER( _settings._preScaler );
+    ADC_SET_SAMPLE_ACCUM( _settings._accum );
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
         ADC->CTRLB.reg = _ctrlB;
@@ -267,51 +636,295 @@ int16_t Analog::readTemperature()
     ADC->SAMPCTRL.reg = ADC_SAMPCTRL_MASK; // 64 ADC clock cycles
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
-        ADC->INPUTCTRL.reg = ADC_INPUTCTRL_GAIN_1X | ADC_INPUTCTRL_MUXPOS_TEMP |
-                             ADC_INPUTCTRL_MUXNEG_GND;
+        ADC->INPUTCTRL.reg = _settings._gain |
+                             ADC_INPUTCTRL_MUXPOS( _posChannel ) |
+                             ADC_INPUTCTRL_MUXNEG( _negChannel );
     } )
 
-    // Enable the ADC
+    // Window thresholds and mode
     ATOMIC_OPERATION( {
         if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
-        ADC->CTRLA.bit.ENABLE = 1;
+        ADC->WINLT.reg = lo;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->WINUT.reg = hi;
+    } )
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->WINCTRL.reg = mode;
     } )
 
-    int16_t val = singleShotConversion();
+    // Conversions are started by events, only a window match interrupts
+    _winCallback = callback;
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    ADC->INTFLAG.reg = ADC_INTFLAG_WINMON | ADC_INTFLAG_RESRDY;
+    ADC->INTENSET.reg = ADC_INTENSET_WINMON;
+    NVIC_EnableIRQ( ADC_IRQn );
+
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.reg = ADC_CTRLA_RUNSTDBY | ADC_CTRLA_ENABLE;
+    } )
+
+    // RTC periodic events (enabled by initRTC) keep running in standby, route
+    // them on the asynchronous path which needs no clock of its own
+    routeEvent( _winEventChannel, EVENT_GEN_RTC_PER( rate ), event_path_async,
+                event_edge_none );
+    addEventUser( _winEventChannel, EVENT_USER_ADC_START );
+
+    return 0;
+}
+
+void Analog::disarmWindow()
+{
+    if( _winEventChannel == -1 ) return;
+
+    freeEventChannel( _winEventChannel );
+    _winEventChannel = -1;
+
+    NVIC_DisableIRQ( ADC_IRQn );
+    ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+    ADC->EVCTRL.reg = 0;
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE_DISABLE;
+    } )
 
     // Disable the peripheral to save power
     TAKE_DOWN_ADC
+    disableClkGenerator( ADC_STANDBY_GCLK );
+    releaseClkGenerator( ADC_STANDBY_GCLK );
 
-    // Take down the temperature sensor
-    SYSCTRL->VREF.bit.TSEN = 0;
+    // OSC8M is left running if it is the main clock by then
+    releaseOSC8MStandby();
+
+    _winCallback = NULL;
+}
+
+void ADC_Handler()
+{
+    uint32_t flags = ( ADC->INTFLAG.reg & ADC->INTENSET.reg );
+    int16_t  val;
+
+    // Event triggered conversions can complete while we are sleeping
+    exitSleep();
+
+    if( flags & ADC_INTFLAG_RESRDY ) {
+        // Reading the result clears the flag
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        val = ADC->RESULT.reg;
+
+        if( _trigDiscard )
+            _trigDiscard = 0;
+        else if( _trigBuffer != NULL ) {
+            _trigBuffer[_trigNdx++] = val;
+            if( _trigNdx >= _trigLen ) {
+                _trigNdx = 0;
+                _trigReady = 1;
+                if( _trigCallback != NULL )
+                    _trigCallback( _trigBuffer, _trigLen );
+            }
+        }
+    }
 
-    // Perform temperature conversion via interpolation using the calibration
-    // values. Calculation assumes that reference voltage is 1 volt, taken from
-    // the data sheet
-    int16_t temp =
-        roomTempVal +
-        ( ( ( val - roomADCVal ) * ( hotRoomTempVal - roomTempVal ) ) /
-          ( hotADCVal - roomADCVal ) );
+    if( flags & ADC_INTFLAG_WINMON ) {
+        ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
 
-    return temp;
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        val = ADC->RESULT.reg;
+        if( _winCallback != NULL ) _winCallback( val );
+    }
 }
 
-void Analog::setPosChannel( int32_t pin )
+// Decoded temperature sensor calibration, read from the NVM temperature log
+// once. The room and hot ADC codes are corrected for the actual value of the
+// internal 1 V reference during calibration and scaled to 16 bit results.
+typedef struct
+{
+    int32_t roomCenti; // Room calibration temperature in 0.01 C
+    int32_t roomCode;  // Room calibration ADC code, 16 bit
+    int32_t slopeQ16;  // 0.01 C per 16 bit ADC code, Q16
+    uint8_t valid;
+} TempCalibration_t;
+
+static TempCalibration_t _tempCal = {0, 0, 0, 0};
+
+// VCC in mV is VCC_MV_NUMERATOR / result, where the band-gap is measured
+// against VDDANA / 2 as a 16 bit result
+#define VCC_MV_NUMERATOR ( (uint32_t)BAND_GAP_MV * 65520UL * 2 )
+
+// Divides hundredths by 100 with rounding, 5243 / 2^19 ~= 1 / 100
+#define CENTI_TO_UNITS( x ) ( ( ( x ) * 5243 + ( 1L << 18 ) ) >> 19 )
+
+static void loadTempCalibration()
+{
+    uint32_t tempLogLow = *(uint32_t *)NVMCTRL_TEMP_LOG;
+    uint32_t tempLogHigh = *(uint32_t *)( NVMCTRL_TEMP_LOG + 4 );
+
+    int32_t roomCenti =
+        (int8_t)( ( tempLogLow & NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Msk ) >>
+                  NVMCTRL_FUSES_ROOM_TEMP_VAL_INT_Pos ) *
+            100 +
+        ( ( tempLogLow & NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC_Msk ) >>
+          NVMCTRL_FUSES_ROOM_TEMP_VAL_DEC_Pos ) *
+            10;
+    int32_t hotCenti =
+        (int8_t)( ( tempLogLow & NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Msk ) >>
+                  NVMCTRL_FUSES_HOT_TEMP_VAL_INT_Pos ) *
+            100 +
+        ( ( tempLogLow & NVMCTRL_FUSES_HOT_TEMP_VAL_DEC_Msk ) >>
+          NVMCTRL_FUSES_HOT_TEMP_VAL_DEC_Pos ) *
+            10;
+
+    // Actual internal 1 V reference in mV at each calibration point
+    int32_t roomInt1V =
+        1000 - (int8_t)( ( tempLogLow & NVMCTRL_FUSES_ROOM_INT1V_VAL_Msk ) >>
+                         NVMCTRL_FUSES_ROOM_INT1V_VAL_Pos );
+    int32_t hotInt1V =
+        1000 - (int8_t)( ( tempLogHigh & NVMCTRL_FUSES_HOT_INT1V_VAL_Msk ) >>
+                         NVMCTRL_FUSES_HOT_INT1V_VAL_Pos );
+
+    int32_t roomADC = ( tempLogHigh & NVMCTRL_FUSES_ROOM_ADC_VAL_Msk ) >>
+                      NVMCTRL_FUSES_ROOM_ADC_VAL_Pos;
+    int32_t hotADC = ( tempLogHigh & NVMCTRL_FUSES_HOT_ADC_VAL_Msk ) >>
+                     NVMCTRL_FUSES_HOT_ADC_VAL_Pos;
+
+    // Scale the 12 bit calibration codes to 16 bit codes against an ideal
+    // 1 V reference
+    int32_t roomCode = ( roomADC * 16 * roomInt1V ) / 1000;
+    int32_t hotCode = ( hotADC * 16 * hotInt1V ) / 1000;
+    if( hotCode == roomCode ) return;
+
+    _tempCal.roomCenti = roomCenti;
+    _tempCal.roomCode = roomCode;
+    _tempCal.slopeQ16 =
+        ( ( hotCenti - roomCenti ) << 16 ) / ( hotCode - roomCode );
+    _tempCal.valid = 1;
+}
+
+// Powers up the ADC for reading the internal channels, the result of every
+// conversion is the 16 bit sum of 64 samples (the ADC shifts the 18 bit sum
+// right by two on its own)
+static void beginInternalSession()
+{
+    BRING_UP_ADC
+
+    ADC_SET_RESOLUTION( ADC_CTRLB_RESSEL_16BIT );
+    ADC_SET_PRESCALER( adcPrescaler( ana_clk_div_8 ) );
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM( ana_accum_64 );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLB.reg = _ctrlB;
+    } )
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_MASK; // 64 ADC clock cycles
+}
+
+static int32_t convertInternal( uint32_t ref, uint32_t muxPos )
+{
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 0;
+    } )
+
+    ADC_SET_REF( ref );
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->INPUTCTRL.reg =
+            ADC_INPUTCTRL_GAIN_1X | muxPos | ADC_INPUTCTRL_MUXNEG_GND;
+    } )
+
+    ATOMIC_OPERATION( {
+        if( ADC_SYNC_BUSY ) ADC_WAIT_SYNC;
+        ADC->CTRLA.bit.ENABLE = 1;
+    } )
+
+    return (uint16_t)singleShotConversion();
+}
+
+static int16_t vccFromResult( int32_t val )
+{
+    if( val <= 0 ) return -1;
+    return VCC_MV_NUMERATOR / val;
+}
+
+static int32_t tempCentiFromResult( int32_t val )
+{
+    if( !_tempCal.valid ) return INT32_MIN;
+
+    int32_t delta = ( val - _tempCal.roomCode ) * _tempCal.slopeQ16;
+    return _tempCal.roomCenti + ( ( delta + ( 1L << 15 ) ) >> 16 );
+}
+
+int16_t Analog::readVCC()
+{
+    int16_t vccMv;
+    readVCCAndTemperature( &vccMv, NULL );
+    return vccMv;
+}
+
+int16_t Analog::readTemperature()
+{
+    int32_t tempCenti = readTemperatureCenti();
+    if( tempCenti == INT32_MIN ) return INT16_MIN;
+    return CENTI_TO_UNITS( tempCenti );
+}
+
+int32_t Analog::readTemperatureCenti()
+{
+    int32_t tempCenti;
+    readVCCAndTemperature( NULL, &tempCenti );
+    return tempCenti;
+}
+
+void Analog::readVCCAndTemperature( int16_t *vccMv, int32_t *tempCenti )
+{
+    if( vccMv == NULL && tempCenti == NULL ) return;
+    if( tempCenti != NULL && !_tempCal.valid ) loadTempCalibration();
+
+    // Both readings share one bring up of the ADC, the internal sources are
+    // enabled for the whole session
+    beginInternalSession();
+    if( vccMv != NULL ) SYSCTRL->VREF.bit.BGOUTEN = 1;
+    if( tempCenti != NULL ) SYSCTRL->VREF.bit.TSEN = 1;
+
+    // Band-gap against VDDANA / 2
+    if( vccMv != NULL )
+        *vccMv = vccFromResult( convertInternal(
+            ana_ref_internal_0_5_vddana, ADC_INPUTCTRL_MUXPOS_BANDGAP ) );
+
+    // Temperature sensor against the internal 1 V reference
+    if( tempCenti != NULL )
+        *tempCenti = tempCentiFromResult(
+            convertInternal( ana_ref_internal_1v, ADC_INPUTCTRL_MUXPOS_TEMP ) );
+
+    // Disable the peripheral and the internal sources to save power
+    TAKE_DOWN_ADC
+    SYSCTRL->VREF.bit.BGOUTEN = 0;
+    SYSCTRL->VREF.bit.TSEN = 0;
+}
+
+int32_t Analog::getPosChannel( int32_t pin )
 {
     // Ensure the pin supports analog, and that the pin is within valid
     // range of analog support
-    if( gArduinoPins[pin].analog == -1 || pin > PINS_COUNT )
-        _posChannel = -1;
-    else {
-        // Set the positive pin, pin mapping is taken directly from the data
-        // sheet. Allowable negative input pins for the SAMD20 are AIN0 -
-        // AIN19
-        _posChannel = gArduinoPins[pin].pin;
-        if( _posChannel < 4 )
-            _posChannel &= 0x1; // Low channels
-        else if( _posChannel > 7 && _posChannel < 12 )
-            _posChannel += 8; // High channels
-    }
+    if( pin < 0 || pin >= PINS_COUNT || gArduinoPins[pin].analog == -1 )
+        return -1;
+
+    // Set the positive pin, pin mapping is taken directly from the data
+    // sheet. Allowable positive input pins for the SAMD20 are AIN0 - AIN19
+    int32_t channel = gArduinoPins[pin].pin;
+    if( channel < 4 )
+        channel &= 0x1; // Low channels
+    else if( channel > 7 && channel < 12 )
+        channel += 8; // High channels
+
+    return channel;
+}
+
+void Analog::setPosChannel( int32_t pin )
+{
+    _posChannel = getPosChannel( pin );
 }
 
 void Analog::setNegChannel( int32_t pin )
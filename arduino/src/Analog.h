@@ -5,6 +5,9 @@
 #include <stdbool.h>
 #include "variant.h"
 
+// Maximum number of consecutive AIN channels the ADC can walk in one scan
+#define ANALOG_SCAN_MAX_CHANNELS 16
+
 typedef enum
 {
     ana_ref_internal_1v = ADC_REFCTRL_REFSEL_INT1V,
@@ -29,6 +32,21 @@ typedef enum
     ana_accum_1024 = ADC_AVGCTRL_SAMPLENUM_1024_Val
 } AnalogAccum_t;
 
+// Oversampling by 4^n samples adds n bits of effective resolution. Latency is
+// getAccumulatedLatency() of the sample count, with the default 1 MHz ADC
+// clock (GCLK0 at 8 MHz, divide by 8) that is roughly:
+//      13 bit:   4 samples,   0.2 ms
+//      14 bit:  16 samples,   0.7 ms
+//      15 bit:  64 samples,   2.5 ms
+//      16 bit: 256 samples,  10.0 ms
+typedef enum
+{
+    ana_oversample_13bit = ADC_AVGCTRL_SAMPLENUM_4_Val,
+    ana_oversample_14bit = ADC_AVGCTRL_SAMPLENUM_16_Val,
+    ana_oversample_15bit = ADC_AVGCTRL_SAMPLENUM_64_Val,
+    ana_oversample_16bit = ADC_AVGCTRL_SAMPLENUM_256_Val
+} AnalogOversample_t;
+
 typedef enum
 {
     ana_resolution_8bit = ADC_CTRLB_RESSEL_8BIT,
@@ -58,6 +76,27 @@ typedef enum
     ana_gain_16x = ADC_INPUTCTRL_GAIN_16X
 } AnalogGain_t;
 
+typedef enum
+{
+    ana_window_above = ADC_WINCTRL_WINMODE_MODE1,  // lo < result
+    ana_window_below = ADC_WINCTRL_WINMODE_MODE2,  // result < hi
+    ana_window_inside = ADC_WINCTRL_WINMODE_MODE3, // lo < result < hi
+    ana_window_outside = ADC_WINCTRL_WINMODE_MODE4 // !( lo < result < hi )
+} AnalogWindowMode_t;
+
+// Conversion rate of an armed window, taken from the RTC periodic events
+typedef enum
+{
+    ana_window_4096hz = 0,
+    ana_window_2048hz = 1,
+    ana_window_1024hz = 2,
+    ana_window_512hz = 3,
+    ana_window_256hz = 4,
+    ana_window_128hz = 5,
+    ana_window_64hz = 6,
+    ana_window_32hz = 7
+} AnalogWindowRate_t;
+
 class AnalogSettings
 {
   public:
@@ -125,16 +164,55 @@ class Analog
 
     int16_t readSingle();
     int16_t readSingle( AnalogSettings settings );
-    void    writeSingle( int16_t val, bool outputInternal = false );
 
+    // Accumulates 2^accum samples and returns the sum scaled to resultBits
+    // (12 - 16), e.g. a 14 bit result is always in the range 0 - 16383. The
+    // reference, prescaler and gain come from the settings of this object.
+    int32_t         readAccumulated( AnalogAccum_t accum, uint8_t resultBits );
+    int32_t         readOversampled( AnalogOversample_t bits );
+    static uint32_t getAccumulatedLatency( AnalogAccum_t     accum,
+                                           AnalogPrescaler_t pre );
+    void            writeSingle( int16_t val, bool outputInternal = false );
+
+    // VCC is in mV, temperature in whole degrees C or in 0.01 C. Calibration
+    // is decoded from the NVM temperature log on first use.
     static int16_t readVCC();
     static int16_t readTemperature();
+    static int32_t readTemperatureCenti();
+    static void    readVCCAndTemperature( int16_t *vccMv, int32_t *tempCenti );
+
+    // Reads each pin in pins into the matching index of results. Pins whose
+    // AIN channels are consecutive are converted in a single hardware scan.
+    // Returns the number of results, or -1 on failure.
+    static int8_t readScan( const int32_t *pins, uint8_t count,
+                            int16_t *results );
+    static int8_t readScan( const int32_t *pins, uint8_t count,
+                            int16_t *results, AnalogSettings settings );
+
+    // Starts a conversion on every event from eventGenerator (see
+    // EventSystem.h) and collects the results into buffer from the ADC
+    // interrupt. The callback is called from the interrupt each time buffer
+    // fills, after which collection wraps back to the start of buffer.
+    int8_t beginTriggered( uint8_t eventGenerator, volatile int16_t *buffer,
+                           uint16_t len,
+                           void ( *callback )( volatile int16_t *buffer,
+                                               uint16_t len ) = NULL );
+    static bool triggeredBatchReady();
+    static void endTriggered();
+
+    // Converts at rate in standby and only wakes the CPU to call callback when
+    // a result matches the window. Thresholds use the configured resolution.
+    int8_t armWindow( int16_t lo, int16_t hi, AnalogWindowMode_t mode,
+                      void ( *callback )( int16_t result ),
+                      AnalogWindowRate_t rate = ana_window_32hz );
+    static void disarmWindow();
 
   private:
     AnalogSettings _settings;
     int32_t        _posInputPin, _negInputPin, _posChannel, _negChannel;
 
-    void setPosChannel( int32_t pin );
+    static int32_t getPosChannel( int32_t pin );
+    void           setPosChannel( int32_t pin );
     void setNegChannel( int32_t pin );
 };
 
@@ -0,0 +1,277 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "AnalogComparator.h"
+#include "clocks.h"
+#include "GPIO.h"
+#include "atomic.h"
+#include "sleep.h"
+#include "EventSystem.h"
+
+#define AC_SYNC_BUSY ( AC->STATUSB.bit.SYNCBUSY )
+#define AC_WAIT_SYNC while( AC_SYNC_BUSY )
+
+// Both comparators share the module, track which ones are in use so the
+// module is only taken down with the last one
+static AnalogComparator *_acInstances[AC_NUM_COMPARATORS] = {NULL, NULL};
+
+// The analog clock must stay below 64 kHz so it always comes from the 32 kHz
+// GCLK1, genClk only clocks the digital side
+static void initACClks( uint32_t genClk )
+{
+    initGenericClk( genClk, GCLK_CLKCTRL_ID_AC_DIG_Val );
+    initGenericClk( GCLK_CLKCTRL_GEN_GCLK1_Val, GCLK_CLKCTRL_ID_AC_ANA_Val );
+}
+
+AnalogComparator::AnalogComparator( uint8_t comparator )
+{
+    _num = ( comparator < AC_NUM_COMPARATORS ) ? comparator : 0;
+    _posChannel = -1;
+    _negChannel = ac_neg_gnd;
+    _scaler = 31; // VDD / 2
+    _hysteresis = false;
+    _isActive = false;
+    _mode = ac_mode_continuous;
+    _intSel = ac_int_toggle;
+    isrPtr = NULL;
+}
+
+int8_t AnalogComparator::begin( int32_t posPin, ACNegInput_t negInput,
+                                int32_t negPin )
+{
+    _posChannel = getACChannel( posPin );
+    if( _posChannel == -1 ) return -1;
+
+    if( negInput == ac_neg_pin ) {
+        _negChannel = getACChannel( negPin );
+        if( _negChannel == -1 ) return -1;
+        pinMode( negPin, gArduinoPins[negPin].analog );
+    }
+    else
+        _negChannel = negInput;
+
+    pinMode( posPin, gArduinoPins[posPin].analog );
+
+    // Bring up the module with the first comparator
+    if( _acInstances[0] == NULL && _acInstances[1] == NULL ) {
+        enableAPBCClk( PM_APBCMASK_AC, 1 );
+        initACClks( GCLK_CLKCTRL_GEN_GCLK0_Val );
+
+        ATOMIC_OPERATION( {
+            if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+            AC->CTRLA.reg = AC_CTRLA_SWRST;
+        } )
+        while( AC->CTRLA.bit.SWRST )
+            ;
+
+        ATOMIC_OPERATION( {
+            if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+            AC->CTRLA.bit.ENABLE = 1;
+        } )
+    }
+
+    _acInstances[_num] = this;
+    _isActive = true;
+    applyConfig();
+
+    return 0;
+}
+
+void AnalogComparator::end()
+{
+    if( !_isActive ) return;
+
+    detachInterrupt();
+    setEventOutput( false );
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->COMPCTRL[_num].reg = 0;
+    } )
+
+    _isActive = false;
+    _acInstances[_num] = NULL;
+
+    // Take down the module with the last comparator
+    if( _acInstances[0] == NULL && _acInstances[1] == NULL ) {
+        NVIC_DisableIRQ( AC_IRQn );
+        ATOMIC_OPERATION( {
+            if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+            AC->CTRLA.reg = AC_CTRLA_SWRST;
+        } )
+        while( AC->CTRLA.bit.SWRST )
+            ;
+
+        disableGenericClk( GCLK_CLKCTRL_ID_AC_DIG_Val );
+        disableGenericClk( GCLK_CLKCTRL_ID_AC_ANA_Val );
+        enableAPBCClk( PM_APBCMASK_AC, 0 );
+    }
+}
+
+// Scaled VDD reference is VDD * ( value + 1 ) / 64
+void AnalogComparator::setScaler( uint8_t value )
+{
+    _scaler = value & AC_SCALER_VALUE_Msk;
+    if( _isActive ) AC->SCALER[_num].reg = AC_SCALER_VALUE( _scaler );
+}
+
+void AnalogComparator::setHysteresis( bool enable )
+{
+    _hysteresis = enable;
+    if( _isActive ) applyConfig();
+}
+
+void AnalogComparator::setMode( ACMode_t mode )
+{
+    _mode = mode;
+    if( _isActive ) applyConfig();
+}
+
+// Keeps the comparators running in standby. The main clock stops in standby so
+// the AC clocks are moved onto the 32 kHz generator, which keeps running.
+void AnalogComparator::setRunInStandby( bool enable )
+{
+    if( !_isActive ) return;
+
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->CTRLA.bit.ENABLE = 0;
+    } )
+
+    initACClks( enable ? GCLK_CLKCTRL_GEN_GCLK1_Val :
+                         GCLK_CLKCTRL_GEN_GCLK0_Val );
+    AC->CTRLA.bit.RUNSTDBY = enable;
+
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->CTRLA.bit.ENABLE = 1;
+    } )
+}
+
+// Drives the comparator output onto the event system, the generator ID for
+// routing is given by getEventGenerator()
+void AnalogComparator::setEventOutput( bool enable )
+{
+    uint32_t bit = ( _num == 0 ) ? AC_EVCTRL_COMPEO0 : AC_EVCTRL_COMPEO1;
+
+    if( enable )
+        AC->EVCTRL.reg |= bit;
+    else
+        AC->EVCTRL.reg &= ~bit;
+}
+
+uint8_t AnalogComparator::getEventGenerator()
+{
+    return ( _num == 0 ) ? EVENT_GEN_AC_COMP0 : EVENT_GEN_AC_COMP1;
+}
+
+void AnalogComparator::attachInterrupt( void ( *isr )(), ACInterrupt_t mode )
+{
+    uint32_t bit = ( _num == 0 ) ? AC_INTENSET_COMP0 : AC_INTENSET_COMP1;
+
+    isrPtr = isr;
+    _intSel = mode;
+    if( _isActive ) applyConfig();
+
+    AC->INTFLAG.reg = bit;
+    AC->INTENSET.reg = bit;
+    NVIC_EnableIRQ( AC_IRQn );
+}
+
+void AnalogComparator::detachInterrupt()
+{
+    AC->INTENCLR.reg = ( _num == 0 ) ? AC_INTENCLR_COMP0 : AC_INTENCLR_COMP1;
+    isrPtr = NULL;
+}
+
+// Returns true when the positive input is above the negative input. In single
+// shot mode a comparison is started and waited on.
+bool AnalogComparator::read()
+{
+    if( !_isActive ) return false;
+
+    if( _mode == ac_mode_single_shot ) {
+        AC->CTRLB.reg = ( _num == 0 ) ? AC_CTRLB_START0 : AC_CTRLB_START1;
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+    }
+
+    // Wait for the comparator to start up, or the comparison to complete
+    while( !( AC->STATUSB.reg & ( 1 << _num ) ) )
+        ;
+
+    return ( AC->STATUSA.reg >> _num ) & 0x1;
+}
+
+void AnalogComparator::IrqHandler()
+{
+    AC->INTFLAG.reg = ( _num == 0 ) ? AC_INTFLAG_COMP0 : AC_INTFLAG_COMP1;
+    if( isrPtr != NULL ) isrPtr();
+}
+
+// AC inputs AIN0 - AIN3 are on PA04 - PA07
+int8_t AnalogComparator::getACChannel( int32_t pin )
+{
+    if( pin < 0 || pin >= PINS_COUNT ) return -1;
+    if( gArduinoPins[pin].port != PORTA ) return -1;
+    if( gArduinoPins[pin].pin < 4 || gArduinoPins[pin].pin > 7 ) return -1;
+
+    return gArduinoPins[pin].pin - 4;
+}
+
+// The comparator control register is enable protected, disable the comparator
+// while the configuration is written
+void AnalogComparator::applyConfig()
+{
+    uint32_t compCtrl = AC_COMPCTRL_MUXPOS( _posChannel ) |
+                        AC_COMPCTRL_MUXNEG( _negChannel ) |
+                        AC_COMPCTRL_INTSEL( _intSel ) |
+                        AC_COMPCTRL_SPEED_LOWPOWER;
+    if( _hysteresis ) compCtrl |= AC_COMPCTRL_HYST;
+    if( _mode == ac_mode_single_shot ) compCtrl |= AC_COMPCTRL_SINGLE;
+
+    AC->SCALER[_num].reg = AC_SCALER_VALUE( _scaler );
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->COMPCTRL[_num].reg = 0;
+    } )
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->COMPCTRL[_num].reg = compCtrl;
+    } )
+    ATOMIC_OPERATION( {
+        if( AC_SYNC_BUSY ) AC_WAIT_SYNC;
+        AC->COMPCTRL[_num].reg = compCtrl | AC_COMPCTRL_ENABLE;
+    } )
+}
+
+void AC_Handler()
+{
+    uint32_t flags = ( AC->INTFLAG.reg & AC->INTENSET.reg );
+
+    // The comparators can wake the processor from sleep
+    exitSleep();
+
+    for( uint8_t i = 0; i < AC_NUM_COMPARATORS; i++ ) {
+        if( ( flags >> i ) & 0x1 ) {
+            if( _acInstances[i] != NULL )
+                _acInstances[i]->IrqHandler();
+            else
+                AC->INTFLAG.reg = ( 1 << i );
+        }
+    }
+}
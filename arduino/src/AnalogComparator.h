@@ -0,0 +1,83 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef ANALOGCOMPARATOR_H_
+#define ANALOGCOMPARATOR_H_
+
+#include <stdint.h>
+#include "sam.h"
+
+#define AC_NUM_COMPARATORS 2
+
+// Negative input selection, the positive input is always one of the AC pins
+// AIN0 - AIN3 (A1 - A4)
+typedef enum
+{
+    ac_neg_pin = -1,
+    ac_neg_gnd = AC_COMPCTRL_MUXNEG_GND_Val,
+    ac_neg_scaled_vdd = AC_COMPCTRL_MUXNEG_VSCALE_Val,
+    ac_neg_bandgap = AC_COMPCTRL_MUXNEG_BANDGAP_Val,
+    ac_neg_dac = AC_COMPCTRL_MUXNEG_DAC_Val
+} ACNegInput_t;
+
+typedef enum
+{
+    ac_mode_continuous,
+    ac_mode_single_shot
+} ACMode_t;
+
+typedef enum
+{
+    ac_int_toggle = AC_COMPCTRL_INTSEL_TOGGLE_Val,
+    ac_int_rising = AC_COMPCTRL_INTSEL_RISING_Val,
+    ac_int_falling = AC_COMPCTRL_INTSEL_FALLING_Val,
+    ac_int_complete = AC_COMPCTRL_INTSEL_EOC_Val
+} ACInterrupt_t;
+
+class AnalogComparator
+{
+  public:
+    AnalogComparator( uint8_t comparator = 0 );
+    int8_t  begin( int32_t posPin, ACNegInput_t negInput = ac_neg_scaled_vdd,
+                   int32_t negPin = -1 );
+    void    end();
+    void    setScaler( uint8_t value );
+    void    setHysteresis( bool enable );
+    void    setMode( ACMode_t mode );
+    void    setRunInStandby( bool enable ); // call after begin()
+    void    setEventOutput( bool enable );
+    uint8_t getEventGenerator();
+    void    attachInterrupt( void ( *isr )(), ACInterrupt_t mode );
+    void    detachInterrupt();
+    bool    read();
+    void    IrqHandler();
+
+  private:
+    uint8_t  _num;
+    int8_t   _posChannel, _negChannel;
+    uint8_t  _scaler;
+    bool     _hysteresis;
+    bool     _isActive;
+    ACMode_t _mode;
+    uint32_t _intSel;
+    void ( *isrPtr )();
+    int8_t getACChannel( int32_t pin );
+    void   applyConfig();
+};
+
+#endif /* ANALOGCOMPARATOR_H_ */
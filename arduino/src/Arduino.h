@@ -82,17 +82,28 @@ void loop( void );
 #include "TimerCounter.h"
 #include "EEPROM.h"
 #include "PWM.h"
+#include "SoftPWM.h"
 #include "Analog.h"
+#include "DACStream.h"
+#include "AnalogComparator.h"
+#include "EdgeCapture.h"
+#include "PulseCounter.h"
+#include "RTCCalibration.h"
 #endif /* __cplusplus */
 #include "delay.h"
+#include "monotonic.h"
 #include "debug_hooks.h"
 #include "clocks.h"
 #include "RTC.h"
+#include "RTCCalendar.h"
 #include "WDT.h"
 #include "NVM.h"
 #include "sleep.h"
+#include "governor.h"
 #include "SysTick.h"
 #include "atomic.h"
+#include "EventSystem.h"
+#include "EventChannel.h"
 #ifdef __cplusplus
 #include "Uart.h"
 #endif
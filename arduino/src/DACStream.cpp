@@ -0,0 +1,201 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "DACStream.h"
+#include "clocks.h"
+#include "GPIO.h"
+#include "atomic.h"
+#include "EventSystem.h"
+
+// DAC register synchronization macros
+#define DAC_SYNC_BUSY ( DAC->STATUS.bit.SYNCBUSY )
+#define DAC_WAIT_SYNC while( DAC_SYNC_BUSY )
+
+// There is only one DAC, the stream that owns it services its interrupts
+static DACStream *_activeStream = NULL;
+
+static void dacStreamTimerISR()
+{
+    if( _activeStream != NULL ) _activeStream->IrqHandler();
+}
+
+DACStream::DACStream( TimerCounter *timer )
+{
+    _timer = timer;
+    _mode = dac_stream_event;
+    _buffer = NULL;
+    _len = 0;
+    _ndx = 0;
+    _underruns = 0;
+    _eventChannel = -1;
+    _isActive = false;
+    _refill = NULL;
+}
+
+int8_t DACStream::begin( uint32_t sampleRate, volatile uint16_t *buffer,
+                         uint16_t len,
+                         void ( *refill )( volatile uint16_t *half,
+                                           uint16_t len ),
+                         DACStreamMode_t mode )
+{
+    if( _timer == NULL || buffer == NULL || len < 2 || sampleRate < 2 )
+        return -1;
+
+    end();
+    if( _activeStream != NULL ) _activeStream->end();
+
+    _buffer = buffer;
+    _len = len & ~0x1; // Must split evenly into two halves
+    _refill = refill;
+    _mode = mode;
+    _underruns = 0;
+
+    if( _mode == dac_stream_event ) {
+        _eventChannel = allocEventChannel();
+        if( _eventChannel == -1 ) return -1;
+    }
+
+    _activeStream = this;
+
+    enableAPBCClk( PM_APBCMASK_DAC, 1 );
+    initGenericClk( GCLK_CLKCTRL_GEN_GCLK0_Val, GCLK_CLKCTRL_ID_DAC_Val );
+    pinMode( PIN_A0, gArduinoPins[PIN_A0].analog );
+
+    ATOMIC_OPERATION( {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->CTRLA.reg = DAC_CTRLA_SWRST;
+    } )
+    while( DAC->CTRLA.bit.SWRST )
+        ;
+
+    ATOMIC_OPERATION( {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->CTRLB.reg = DAC_CTRLB_REFSEL_AVCC | DAC_CTRLB_EOEN;
+    } )
+
+    if( _mode == dac_stream_event ) DAC->EVCTRL.reg = DAC_EVCTRL_STARTEI;
+
+    ATOMIC_OPERATION( {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->CTRLA.reg = DAC_CTRLA_ENABLE;
+    } )
+
+    // Preload the first sample
+    _ndx = 0;
+    _isActive = true;
+    ATOMIC_OPERATION( {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->DATA.reg = nextSample();
+    } )
+
+    // In event mode each start event moves DATABUF into DATA, the empty
+    // interrupt then loads the next sample into DATABUF ahead of the next
+    // event. The timer match rate is twice the requested timer frequency.
+    if( _mode == dac_stream_event ) {
+        DAC->INTFLAG.reg = DAC_INTFLAG_UNDERRUN;
+        DAC->INTENSET.reg = DAC_INTENSET_EMPTY | DAC_INTENSET_UNDERRUN;
+        NVIC_EnableIRQ( DAC_IRQn );
+
+        _timer->begin( sampleRate / 2, false, tc_mode_16_bit, false,
+                       tc_event_mc0 );
+        routeEvent( _eventChannel, _timer->getEventGenerator( tc_event_mc0 ),
+                    event_path_async, event_edge_none );
+        addEventUser( _eventChannel, EVENT_USER_DAC_START );
+    }
+    else {
+        _timer->deregisterISR();
+        _timer->registerISR( dacStreamTimerISR );
+        _timer->begin( sampleRate / 2, false, tc_mode_16_bit, true );
+    }
+
+    return 0;
+}
+
+void DACStream::end()
+{
+    if( !_isActive ) return;
+    _isActive = false;
+
+    _timer->end();
+    _timer->deregisterISR();
+    if( _eventChannel != -1 ) {
+        freeEventChannel( _eventChannel );
+        _eventChannel = -1;
+    }
+
+    NVIC_DisableIRQ( DAC_IRQn );
+    DAC->INTENCLR.reg = DAC_INTENCLR_EMPTY | DAC_INTENCLR_UNDERRUN;
+    DAC->EVCTRL.reg = 0;
+    ATOMIC_OPERATION( {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->CTRLA.reg = 0;
+    } )
+
+    disableGenericClk( GCLK_CLKCTRL_ID_DAC_Val );
+    enableAPBCClk( PM_APBCMASK_DAC, 0 );
+
+    if( _activeStream == this ) _activeStream = NULL;
+}
+
+// Returns the next sample and hands a consumed half back to the caller
+uint16_t DACStream::nextSample()
+{
+    uint16_t sample = _buffer[_ndx++] & 0x3FF;
+    uint16_t half = _len >> 1;
+
+    if( _ndx == half ) {
+        if( _refill != NULL ) _refill( _buffer, half );
+    }
+    else if( _ndx >= _len ) {
+        _ndx = 0;
+        if( _refill != NULL ) _refill( &_buffer[half], half );
+    }
+
+    return sample;
+}
+
+void DACStream::IrqHandler()
+{
+    if( !_isActive ) return;
+
+    if( _mode == dac_stream_event ) {
+        uint32_t flags = DAC->INTFLAG.reg & DAC->INTENSET.reg;
+
+        // A start event arrived before the next sample was loaded
+        if( flags & DAC_INTFLAG_UNDERRUN ) {
+            DAC->INTFLAG.reg = DAC_INTFLAG_UNDERRUN;
+            _underruns++;
+        }
+
+        // Writing DATABUF clears the empty flag
+        if( flags & DAC_INTFLAG_EMPTY ) {
+            if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+            DAC->DATABUF.reg = nextSample();
+        }
+    }
+    else {
+        if( DAC_SYNC_BUSY ) DAC_WAIT_SYNC;
+        DAC->DATA.reg = nextSample();
+    }
+}
+
+void DAC_Handler()
+{
+    if( _activeStream != NULL ) _activeStream->IrqHandler();
+}
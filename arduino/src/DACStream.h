@@ -0,0 +1,67 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef DACSTREAM_H_
+#define DACSTREAM_H_
+
+#include <stdint.h>
+#include "TimerCounter.h"
+
+typedef enum
+{
+    dac_stream_event, // Timer events load each sample, jitter free
+    dac_stream_isr    // Timer interrupt writes each sample
+} DACStreamMode_t;
+
+// Streams 10 bit samples out of the DAC (A0) at a fixed rate from a circular
+// buffer. The buffer is consumed in two halves, refill is called from interrupt
+// context with the half that was just played so it can be refilled while the
+// other half plays.
+class DACStream
+{
+  public:
+    DACStream( TimerCounter *timer );
+    int8_t   begin( uint32_t sampleRate, volatile uint16_t *buffer,
+                    uint16_t len,
+                    void ( *refill )( volatile uint16_t *half, uint16_t len ),
+                    DACStreamMode_t mode = dac_stream_event );
+    void     end();
+    void     IrqHandler();
+    uint32_t getUnderruns()
+    {
+        return _underruns;
+    }
+    bool isActive()
+    {
+        return _isActive;
+    }
+
+  private:
+    TimerCounter *     _timer;
+    DACStreamMode_t    _mode;
+    volatile uint16_t *_buffer;
+    uint16_t           _len;
+    volatile uint16_t  _ndx;
+    volatile uint32_t  _underruns;
+    int8_t             _eventChannel;
+    bool               _isActive;
+    void ( *_refill )( volatile uint16_t *half, uint16_t len );
+    uint16_t nextSample();
+};
+
+#endif /* DACSTREAM_H_ */
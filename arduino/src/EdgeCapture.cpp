@@ -0,0 +1,196 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "EdgeCapture.h"
+#include "atomic.h"
+
+// Only one capture can own the EIC callback at a time
+static EdgeCapture *_activeCapture = NULL;
+
+static void edgeCaptureISR()
+{
+    if( _activeCapture != NULL ) _activeCapture->IrqHandler();
+}
+
+EdgeCapture::EdgeCapture( TimerCounter *timer )
+{
+    _timer = timer;
+    _buffer = NULL;
+    _len = 0;
+    _head = 0;
+    _tail = 0;
+    _lastTicks = 0;
+    _overflows = 0;
+    _gapTicks = 0;
+    _ticksPerUs = 0;
+    _gapUs = 0;
+    _sinceEdgeUs = 0;
+    _pin = 0;
+    _inReg = NULL;
+    _inBit = 0;
+    _isActive = false;
+}
+
+int8_t EdgeCapture::begin( uint32_t pin, volatile EdgeEvent_t *buffer,
+                           uint16_t len, uint32_t gapUs )
+{
+    if( _timer == NULL || buffer == NULL || len < 2 ) return -1;
+    if( pin >= PINS_COUNT || gArduinoPins[pin].extInt == -1 ) return -1;
+    if( _activeCapture != NULL && _activeCapture != this ) return -1;
+
+    end();
+
+    // The timestamp base, the timer must be able to run in 32 bit mode
+    _timer->beginFreeRunning( tc_mode_32_bit, TC_CTRLA_PRESCALER_DIV1_Val );
+    if( !_timer->isActive() ) return -1;
+
+    _ticksPerUs = _timer->getCaptureFrequency() / 1000000;
+    _gapUs = gapUs;
+    _gapTicks = gapUs * _ticksPerUs;
+    _buffer = buffer;
+    _len = len;
+    _head = 0;
+    _tail = 0;
+    _overflows = 0;
+    _pin = pin;
+    _inReg = &PORT->Group[gArduinoPins[pin].port].IN.reg;
+    _inBit = gArduinoPins[pin].pin;
+
+    // Makes the first edge the start of a frame
+    _lastTicks = _timer->getCount() - _gapTicks;
+
+    _activeCapture = this;
+    _isActive = true;
+    attachInterrupt( pin, edgeCaptureISR, CHANGE );
+
+    // The EIC takes over the pin, keep the input buffer on so the level can be
+    // read at each edge
+    PORT->Group[gArduinoPins[pin].port].PINCFG[gArduinoPins[pin].pin].reg |=
+        PORT_PINCFG_INEN;
+
+    // The free running count follows the core clock, rescale when it changes
+    registerClockNotifier( clockPreChange, clockPostChange, this );
+
+    return 0;
+}
+
+// Saves the time since the last edge at the old rate, up to the gap
+void EdgeCapture::clockPreChange( void *ctx )
+{
+    EdgeCapture *cap = (EdgeCapture *)ctx;
+
+    ATOMIC_OPERATION( {
+        uint32_t since = cap->_timer->getCount() - cap->_lastTicks;
+        if( since > cap->_gapTicks ) since = cap->_gapTicks;
+        cap->_sinceEdgeUs = cap->_ticksPerUs ? since / cap->_ticksPerUs : 0;
+    } )
+}
+
+// Converts the gap to the new rate and moves the last edge to the same time
+// before now, so the gap test keeps measuring from the right place
+void EdgeCapture::clockPostChange( void *ctx )
+{
+    EdgeCapture *cap = (EdgeCapture *)ctx;
+
+    ATOMIC_OPERATION( {
+        cap->_ticksPerUs = cap->_timer->getCaptureFrequency() / 1000000;
+        cap->_gapTicks = cap->_gapUs * cap->_ticksPerUs;
+        cap->_lastTicks = cap->_timer->getCount() -
+                          cap->_sinceEdgeUs * cap->_ticksPerUs;
+    } )
+}
+
+void EdgeCapture::end()
+{
+    if( !_isActive ) return;
+
+    unregisterClockNotifier( clockPostChange, this );
+    detachInterrupt( _pin );
+    _timer->end();
+    _isActive = false;
+    _activeCapture = NULL;
+}
+
+// Copies the oldest complete frame into frame and returns the number of
+// edges, 0 if no frame is complete yet, or -1 if the frame did not fit in
+// maxLen (the frame is dropped).
+int16_t EdgeCapture::readFrame( EdgeEvent_t *frame, uint16_t maxLen )
+{
+    uint16_t head, ndx;
+    uint32_t lastTicks;
+    uint16_t cnt = 1;
+
+    if( !_isActive ) return 0;
+
+    ATOMIC_OPERATION( {
+        head = _head;
+        lastTicks = _lastTicks;
+    } )
+    if( _tail == head ) return 0;
+
+    // The frame runs until the start of the next frame
+    ndx = ( _tail + 1 < _len ) ? _tail + 1 : 0;
+    while( ndx != head && !_buffer[ndx].start ) {
+        ndx = ( ndx + 1 < _len ) ? ndx + 1 : 0;
+        cnt++;
+    }
+
+    // Or until the head once the gap has passed
+    if( ndx == head && ( _timer->getCount() - lastTicks ) < _gapTicks )
+        return 0;
+
+    if( cnt > maxLen ) {
+        _tail = ndx;
+        return -1;
+    }
+
+    for( uint16_t i = 0; i < cnt; i++ ) {
+        frame[i].ticks = _buffer[_tail].ticks;
+        frame[i].level = _buffer[_tail].level;
+        frame[i].start = _buffer[_tail].start;
+        _tail = ( _tail + 1 < _len ) ? _tail + 1 : 0;
+    }
+
+    return cnt;
+}
+
+uint32_t EdgeCapture::ticksToMicros( uint32_t ticks )
+{
+    return ( _ticksPerUs ) ? ticks / _ticksPerUs : 0;
+}
+
+// Called from the EIC interrupt on every edge, keep it short to follow edge
+// rates up to ~50 kHz
+void EdgeCapture::IrqHandler()
+{
+    uint32_t now = _timer->getCount();
+    uint16_t next = ( _head + 1 < _len ) ? _head + 1 : 0;
+
+    if( next == _tail ) {
+        _overflows++;
+        _lastTicks = now;
+        return;
+    }
+
+    _buffer[_head].ticks = now;
+    _buffer[_head].level = ( *_inReg >> _inBit ) & 0x1;
+    _buffer[_head].start = ( ( now - _lastTicks ) >= _gapTicks );
+    _lastTicks = now;
+    _head = next;
+}
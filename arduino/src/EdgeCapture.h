@@ -0,0 +1,78 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef EDGECAPTURE_H_
+#define EDGECAPTURE_H_
+
+#include <stdint.h>
+#include "TimerCounter.h"
+
+typedef struct
+{
+    uint32_t ticks; // Timer count at the edge
+    uint8_t  level; // Pin level after the edge
+    uint8_t  start; // First edge after a gap, i.e. the start of a frame
+} EdgeEvent_t;
+
+// Records every edge on a pin with a timestamp from a free running 32 bit
+// timer into a ring buffer from the EIC interrupt. Frames are separated by
+// gaps with no edges for at least gapUs, readFrame() returns a frame once the
+// next frame has started or the gap has passed. The timer wraps after ~89 s at
+// 48 MHz, readFrame() must be polled more often than that. The timestamps
+// follow the CPU clock, a frame spanning a clock change mixes both rates.
+class EdgeCapture
+{
+  public:
+    EdgeCapture( TimerCounter *timer );
+    int8_t   begin( uint32_t pin, volatile EdgeEvent_t *buffer, uint16_t len,
+                    uint32_t gapUs );
+    void     end();
+    int16_t  readFrame( EdgeEvent_t *frame, uint16_t maxLen );
+    uint32_t ticksToMicros( uint32_t ticks );
+    void     IrqHandler();
+    uint32_t getOverflows()
+    {
+        return _overflows;
+    }
+    bool isActive()
+    {
+        return _isActive;
+    }
+
+  private:
+    TimerCounter *        _timer;
+    volatile EdgeEvent_t *_buffer;
+    uint16_t              _len;
+    volatile uint16_t     _head;
+    volatile uint16_t     _tail;
+    volatile uint32_t     _lastTicks;
+    volatile uint32_t     _overflows;
+    uint32_t              _gapTicks;
+    uint32_t              _ticksPerUs;
+    uint32_t              _gapUs;
+    uint32_t              _sinceEdgeUs; // Saved across a CPU clock change
+    uint32_t              _pin;
+    const volatile uint32_t *_inReg;
+    uint8_t               _inBit;
+    bool                  _isActive;
+
+    static void clockPreChange( void *ctx );
+    static void clockPostChange( void *ctx );
+};
+
+#endif /* EDGECAPTURE_H_ */
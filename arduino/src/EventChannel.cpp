@@ -0,0 +1,85 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "EventChannel.h"
+
+EventChannel::EventChannel()
+{
+    _channel = -1;
+}
+
+// Allocates a channel on the first call and routes the generator to it, later
+// calls re-route the same channel. Returns -1 if no channel is free.
+int8_t EventChannel::begin( uint8_t generator, EventPath_t path,
+                            EventEdge_t edge )
+{
+    if( _channel == -1 ) _channel = allocEventChannel();
+    if( _channel == -1 ) return -1;
+
+    return routeEvent( _channel, generator, path, edge );
+}
+
+void EventChannel::end()
+{
+    freeEventChannel( _channel );
+    _channel = -1;
+}
+
+int8_t EventChannel::addUser( uint8_t user )
+{
+    if( _channel == -1 ) return -1;
+    return addEventUser( _channel, user );
+}
+
+void EventChannel::removeUser( uint8_t user )
+{
+    if( _channel == -1 ) return;
+    removeEventUser( _channel, user );
+}
+
+int8_t EventChannel::trigger()
+{
+    return triggerEvent( _channel );
+}
+
+bool EventChannel::isBusy()
+{
+    return eventChannelBusy( _channel ) == 1;
+}
+
+bool EventChannel::usersReady()
+{
+    return eventUsersReady( _channel ) == 1;
+}
+
+// Returns true if an event was lost since the last call, synchronous and
+// re-synchronized paths only
+bool EventChannel::overrun()
+{
+    return eventOverrun( _channel ) == 1;
+}
+
+int8_t EventChannel::attachOverrunInterrupt( void ( *isr )( int8_t channel ) )
+{
+    return attachEventOverrunISR( _channel, isr );
+}
+
+void EventChannel::detachOverrunInterrupt()
+{
+    detachEventOverrunISR( _channel );
+}
@@ -0,0 +1,51 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef EVENTCHANNEL_H_
+#define EVENTCHANNEL_H_
+
+#include <stdint.h>
+#include "EventSystem.h"
+
+// A single event system channel, a generator routed to one or more users
+// without the CPU. See EventSystem.h for the generator and user numbers.
+class EventChannel
+{
+  public:
+    EventChannel();
+    int8_t begin( uint8_t generator, EventPath_t path = event_path_async,
+                  EventEdge_t edge = event_edge_rising );
+    void   end();
+    int8_t addUser( uint8_t user );
+    void   removeUser( uint8_t user );
+    int8_t trigger();
+    bool   isBusy();
+    bool   usersReady();
+    bool   overrun();
+    int8_t attachOverrunInterrupt( void ( *isr )( int8_t channel ) );
+    void   detachOverrunInterrupt();
+    int8_t getChannel()
+    {
+        return _channel;
+    }
+
+  private:
+    int8_t _channel;
+};
+
+#endif /* EVENTCHANNEL_H_ */
@@ -0,0 +1,223 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "sam.h"
+#include "EventSystem.h"
+#include "clocks.h"
+#include "atomic.h"
+#include "sleep.h"
+
+#define EVSYS_CHANNEL_VALID( ch ) \
+    ( ( ch ) >= 0 && ( ch ) < EVSYS_NUM_CHANNELS && \
+      ( _evChannelsUsed & ( 1 << ( ch ) ) ) )
+
+// Channels in use, the users attached to each channel so they can be released
+// with the channel, and the routing so software events can rewrite it
+static uint8_t  _evChannelsUsed = 0;
+static uint16_t _evChannelUsers[EVSYS_NUM_CHANNELS];
+static uint32_t _evChannelConfig[EVSYS_NUM_CHANNELS];
+static void ( *_evOverrunISRs[EVSYS_NUM_CHANNELS] )( int8_t );
+
+// Allocates a free event channel, powering up the event system on the first
+// allocation. Returns the channel number or -1 if none are free.
+int8_t allocEventChannel()
+{
+    int8_t channel = -1;
+
+    ATOMIC_OPERATION( {
+        for( uint8_t i = 0; i < EVSYS_NUM_CHANNELS; i++ ) {
+            if( !( _evChannelsUsed & ( 1 << i ) ) ) {
+                channel = i;
+                break;
+            }
+        }
+
+        if( channel != -1 ) {
+            if( _evChannelsUsed == 0 ) {
+                enableAPBCClk( PM_APBCMASK_EVSYS, 1 );
+                EVSYS->CTRL.reg = EVSYS_CTRL_SWRST;
+            }
+
+            _evChannelsUsed |= ( 1 << channel );
+            _evChannelUsers[channel] = 0;
+            _evChannelConfig[channel] = EVSYS_CHANNEL_CHANNEL( channel );
+        }
+    } )
+
+    return channel;
+}
+
+// Detaches all users from the channel, stops its generic clock, and powers down
+// the event system once the last channel is released
+void freeEventChannel( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return;
+
+    detachEventOverrunISR( channel );
+
+    for( uint8_t user = 0; user <= EVENT_USER_MAX; user++ ) {
+        if( _evChannelUsers[channel] & ( 1 << user ) )
+            removeEventUser( channel, user );
+    }
+
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL( channel );
+    disableGenericClk( GCLK_CLKCTRL_ID_EVSYS_CHANNEL_0_Val + channel );
+
+    ATOMIC_OPERATION( {
+        _evChannelsUsed &= ~( 1 << channel );
+        if( _evChannelsUsed == 0 ) enableAPBCClk( PM_APBCMASK_EVSYS, 0 );
+    } )
+}
+
+// Connects a generator to the channel. The synchronous and re-synchronized
+// paths are clocked from GCLK0, the asynchronous path needs no clock and works
+// in standby but does not support edge detection or overrun flags.
+int8_t routeEvent( int8_t channel, uint8_t generator, EventPath_t path,
+                   EventEdge_t edge )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+
+    if( path == event_path_async ) {
+        edge = event_edge_none;
+        disableGenericClk( GCLK_CLKCTRL_ID_EVSYS_CHANNEL_0_Val + channel );
+    }
+    else {
+        initGenericClk( GCLK_CLKCTRL_GEN_GCLK0_Val,
+                        GCLK_CLKCTRL_ID_EVSYS_CHANNEL_0_Val + channel );
+    }
+
+    _evChannelConfig[channel] =
+        EVSYS_CHANNEL_CHANNEL( channel ) | EVSYS_CHANNEL_EVGEN( generator ) |
+        EVSYS_CHANNEL_PATH( path ) | EVSYS_CHANNEL_EDGSEL( edge );
+    EVSYS->CHANNEL.reg = _evChannelConfig[channel];
+
+    return 0;
+}
+
+// Attaches a user to the channel, the user channel field is offset by one as
+// zero means no channel. A user listens to one channel at a time, so it is
+// dropped from the channel it was on before.
+int8_t addEventUser( int8_t channel, uint8_t user )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+    if( user > EVENT_USER_MAX ) return -1;
+
+    ATOMIC_OPERATION( {
+        for( uint8_t i = 0; i < EVSYS_NUM_CHANNELS; i++ )
+            _evChannelUsers[i] &= ~( 1 << user );
+        EVSYS->USER.reg =
+            EVSYS_USER_USER( user ) | EVSYS_USER_CHANNEL( channel + 1 );
+        _evChannelUsers[channel] |= ( 1 << user );
+    } )
+
+    return 0;
+}
+
+// Detaches the user if it is on the channel, a user that has moved to another
+// channel stays there
+void removeEventUser( int8_t channel, uint8_t user )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return;
+    if( user > EVENT_USER_MAX ) return;
+
+    ATOMIC_OPERATION( {
+        if( _evChannelUsers[channel] & ( 1 << user ) ) {
+            EVSYS->USER.reg = EVSYS_USER_USER( user );
+            _evChannelUsers[channel] &= ~( 1 << user );
+        }
+    } )
+}
+
+// Generates an event on the channel from software, as if its generator had
+// fired
+int8_t triggerEvent( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+
+    EVSYS->CHANNEL.reg = _evChannelConfig[channel] | EVSYS_CHANNEL_SWEVT;
+    return 0;
+}
+
+// Returns 1 while an event is waiting on the users of the channel, synchronous
+// and re-synchronized paths only
+int8_t eventChannelBusy( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+
+    return ( EVSYS->CHSTATUS.reg & ( EVSYS_CHSTATUS_CHBUSY0 << channel ) ) != 0;
+}
+
+// Returns 1 when all users of the channel are ready for the next event,
+// synchronous and re-synchronized paths only
+int8_t eventUsersReady( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+
+    return ( EVSYS->CHSTATUS.reg & ( EVSYS_CHSTATUS_USRRDY0 << channel ) ) != 0;
+}
+
+// Returns 1 and clears the flag if an event arrived while the users were still
+// busy with the previous one and was lost. The asynchronous path has no
+// overrun detection and always returns 0.
+int8_t eventOverrun( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return -1;
+    if( !( EVSYS->INTFLAG.reg & ( EVSYS_INTFLAG_OVR0 << channel ) ) ) return 0;
+
+    EVSYS->INTFLAG.reg = EVSYS_INTFLAG_OVR0 << channel;
+    return 1;
+}
+
+// Calls isr with the channel number from the event system interrupt on every
+// overrun of the channel
+int8_t attachEventOverrunISR( int8_t channel, void ( *isr )( int8_t ) )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) || isr == 0 ) return -1;
+
+    _evOverrunISRs[channel] = isr;
+    EVSYS->INTFLAG.reg = EVSYS_INTFLAG_OVR0 << channel;
+    EVSYS->INTENSET.reg = EVSYS_INTENSET_OVR0 << channel;
+    NVIC_EnableIRQ( EVSYS_IRQn );
+
+    return 0;
+}
+
+void detachEventOverrunISR( int8_t channel )
+{
+    if( !EVSYS_CHANNEL_VALID( channel ) ) return;
+
+    EVSYS->INTENCLR.reg = EVSYS_INTENCLR_OVR0 << channel;
+    _evOverrunISRs[channel] = 0;
+
+    if( !( EVSYS->INTENSET.reg & EVSYS_INTENSET_OVR_Msk ) )
+        NVIC_DisableIRQ( EVSYS_IRQn );
+}
+
+void EVSYS_Handler()
+{
+    uint32_t flags = EVSYS->INTFLAG.reg & EVSYS->INTENSET.reg;
+
+    // The event system can wake the processor, ensure we exit sleep properly
+    exitSleep();
+
+    EVSYS->INTFLAG.reg = flags;
+    for( int8_t ch = 0; ch < EVSYS_NUM_CHANNELS; ch++ ) {
+        if( ( flags & ( EVSYS_INTFLAG_OVR0 << ch ) ) && _evOverrunISRs[ch] )
+            _evOverrunISRs[ch]( ch );
+    }
+}
@@ -0,0 +1,89 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef EVENTSYSTEM_H_
+#define EVENTSYSTEM_H_
+
+#include <stdint.h>
+
+#define EVSYS_NUM_CHANNELS 8
+
+// Event generators, mapped directly from the data sheet EVSYS CHANNEL.EVGEN
+// table
+#define EVENT_GEN_NONE 0x00
+#define EVENT_GEN_RTC_CMP0 0x01
+#define EVENT_GEN_RTC_CMP1 0x02
+#define EVENT_GEN_RTC_OVF 0x03
+#define EVENT_GEN_RTC_PER( n ) ( 0x04 + ( n ) )
+#define EVENT_GEN_EIC( n ) ( 0x0C + ( n ) )
+#define EVENT_GEN_TC_OVF( n ) ( 0x1C + ( ( n ) * 3 ) )
+#define EVENT_GEN_TC_MC0( n ) ( 0x1D + ( ( n ) * 3 ) )
+#define EVENT_GEN_TC_MC1( n ) ( 0x1E + ( ( n ) * 3 ) )
+#define EVENT_GEN_ADC_RESRDY 0x34
+#define EVENT_GEN_ADC_WINMON 0x35
+#define EVENT_GEN_AC_COMP0 0x36
+#define EVENT_GEN_AC_COMP1 0x37
+#define EVENT_GEN_AC_WIN0 0x38
+#define EVENT_GEN_DAC_EMPTY 0x39
+
+// Event users, mapped directly from the data sheet EVSYS USER.USER table
+#define EVENT_USER_TC( n ) ( n )
+#define EVENT_USER_ADC_START 0x08
+#define EVENT_USER_ADC_SYNC 0x09
+#define EVENT_USER_AC_COMP0 0x0A
+#define EVENT_USER_AC_COMP1 0x0B
+#define EVENT_USER_DAC_START 0x0C
+#define EVENT_USER_MAX EVENT_USER_DAC_START
+#define EVENT_USER_NONE 0xFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    event_path_sync = 0x0,
+    event_path_resync = 0x1,
+    event_path_async = 0x2
+} EventPath_t;
+
+typedef enum
+{
+    event_edge_none = 0x0,
+    event_edge_rising = 0x1,
+    event_edge_falling = 0x2,
+    event_edge_both = 0x3
+} EventEdge_t;
+
+int8_t allocEventChannel();
+void   freeEventChannel( int8_t channel );
+int8_t routeEvent( int8_t channel, uint8_t generator, EventPath_t path,
+                   EventEdge_t edge );
+int8_t addEventUser( int8_t channel, uint8_t user );
+void   removeEventUser( int8_t channel, uint8_t user );
+int8_t triggerEvent( int8_t channel );
+int8_t eventChannelBusy( int8_t channel );
+int8_t eventUsersReady( int8_t channel );
+int8_t eventOverrun( int8_t channel );
+int8_t attachEventOverrunISR( int8_t channel, void ( *isr )( int8_t ) );
+void   detachEventOverrunISR( int8_t channel );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTSYSTEM_H_ */
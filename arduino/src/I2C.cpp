@@ -5,13 +5,35 @@ I2C::I2C( SERCOM *pSercom, int pinSDA, int pinSCL )
     _SDA = pinSDA;
     _SCL = pinSCL;
     _pSercom = pSercom;
+    _fastMode = false;
+    _minClk = -1;
 }
 
 void I2C::InitMaster( bool fastMode )
 {
     pinMode( _SDA, gArduinoPins[_SDA].i2c );
     pinMode( _SCL, gArduinoPins[_SCL].i2c );
+
+    // SCL is the core clock / ( 10 + 2 * BAUD ), keep the governor from going
+    // below the clock the bus rate needs with a BAUD of 0
+    if( _minClk != -1 ) releaseMinCPUClk( (CPUClkSrc_t)_minClk );
+    _minClk = cpuClkForHz( fastMode ? 4000000ul : 1000000ul );
+    requestMinCPUClk( (CPUClkSrc_t)_minClk );
+
     _pSercom->initMasterWIRE( fastMode );
+
+    // BAUD is computed from the core clock, recompute it when that changes
+    _fastMode = fastMode;
+    registerClockNotifier( NULL, clockPostChange, this );
+}
+
+// Transactions block until they finish, so unless the clock is changed from an
+// interrupt none is in progress
+void I2C::clockPostChange( void *ctx )
+{
+    I2C *i2c = (I2C *)ctx;
+
+    i2c->_pSercom->setBaudrateWIRE( i2c->_fastMode );
 }
 
 int I2C::MasterWrite( uint8_t addr, uint8_t *data, int len, bool stop )
@@ -98,7 +120,13 @@ void I2C::ForceResetBus()
 
 void I2C::End()
 {
+    unregisterClockNotifier( clockPostChange, this );
     _pSercom->disableWIRE();
+
+    if( _minClk != -1 ) {
+        releaseMinCPUClk( (CPUClkSrc_t)_minClk );
+        _minClk = -1;
+    }
 }
 
 I2C TwoWire( &PERIPH_WIRE, PIN_WIRE_SDA, PIN_WIRE_SCL );
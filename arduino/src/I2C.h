@@ -24,6 +24,10 @@ class I2C
   private:
     SERCOM *_pSercom;
     int     _SDA, _SCL;
+    bool    _fastMode;
+    int8_t  _minClk;
+
+    static void clockPostChange( void *ctx );
 };
 
 extern I2C TwoWire;
@@ -32,11 +32,23 @@ void PWM::begin( uint32_t frequency, uint8_t dutyCycle )
     _timer->beginPWM( frequency, CHECK_DUTY_CYCLE( dutyCycle ) );
 }
 
+// Both timer outputs with 16 bit duty cycles, see TimerCounter::beginDualPWM()
+uint32_t PWM::beginDual( uint32_t frequency, uint8_t resolutionBits )
+{
+    _timer->end();
+    return _timer->beginDualPWM( frequency, resolutionBits );
+}
+
 void PWM::setDutyCycle( uint8_t dutyCycle )
 {
     _timer->setPWMDutyCycle( CHECK_DUTY_CYCLE( dutyCycle ) );
 }
 
+void PWM::setDuty( uint8_t channel, uint16_t duty )
+{
+    _timer->setPWMDuty( channel, duty );
+}
+
 void PWM::pause()
 {
     _timer->pause();
@@ -26,11 +26,13 @@ class PWM
 {
   public:
     PWM( TimerCounter *tc );
-    void begin( uint32_t frequency, uint8_t dutyCycle );
-    void setDutyCycle( uint8_t dutyCycle );
-    void pause();
-    void resume();
-    void end();
+    void     begin( uint32_t frequency, uint8_t dutyCycle );
+    uint32_t beginDual( uint32_t frequency, uint8_t resolutionBits );
+    void     setDutyCycle( uint8_t dutyCycle );
+    void     setDuty( uint8_t channel, uint16_t duty );
+    void     pause();
+    void     resume();
+    void     end();
 
   private:
     bool          _isPaused;
@@ -0,0 +1,137 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "PulseCounter.h"
+
+static PulseCounter *_activeCounter = NULL;
+
+static void pulseCounterISR()
+{
+    if( _activeCounter != NULL ) _activeCounter->IrqHandler();
+}
+
+PulseCounter::PulseCounter( TimerCounter *timer )
+{
+    _timer = timer;
+    _overflows = 0;
+    _base = 0;
+    _countBits = 16;
+    _pin = 0;
+    _isActive = false;
+    _eicWasLowPower = false;
+}
+
+// Starts counting sense edges (RISING, FALLING or CHANGE) on the pin from
+// zero. Returns -1 if the pin can't generate events, no event channel is free,
+// or another counter is running.
+int8_t PulseCounter::begin( uint32_t pin, uint32_t sense )
+{
+    uint8_t  user = _timer->getEventUser();
+    TCMode_t mode = tc_mode_16_bit;
+
+    if( user == EVENT_USER_NONE ) return -1;
+    if( _activeCounter != NULL && _activeCounter != this ) return -1;
+    if( _isActive ) end();
+
+    int8_t extInt = attachEventOutput( pin, sense );
+    if( extInt == -1 ) return -1;
+
+    // The EIC has to keep detecting edges in standby, attaching brings it up
+    // on the main clock if nothing else was using it
+    _eicWasLowPower = interruptLowPowerModeActive();
+    interruptlowPowerMode( true );
+
+    if( _channel.begin( EVENT_GEN_EIC( extInt ), event_path_async ) != 0 ) {
+        detachEventOutput( pin );
+        interruptlowPowerMode( _eicWasLowPower );
+        return -1;
+    }
+    _pin = pin;
+    _overflows = 0;
+    _base = 0;
+    _activeCounter = this;
+
+    // Only the overflow interrupt wakes the CPU, the 32 bit counter would take
+    // days to overflow at the fastest rate it can count in standby. The TC
+    // event users are numbered by timer so even users are even timers.
+    if( ( user % 2 ) == 0 ) mode = tc_mode_32_bit;
+    _countBits = ( mode == tc_mode_32_bit ) ? 32 : 16;
+    _timer->registerISR( pulseCounterISR );
+    _timer->beginEventCounter( mode, true, true );
+    _channel.addUser( user );
+
+    _isActive = true;
+    return 0;
+}
+
+void PulseCounter::end()
+{
+    if( !_isActive ) return;
+
+    _channel.end();
+    _timer->deregisterISR();
+    _timer->end();
+    detachEventOutput( _pin );
+    interruptlowPowerMode( _eicWasLowPower );
+
+    _activeCounter = NULL;
+    _isActive = false;
+}
+
+// Returns the number of edges counted since begin() or clear()
+uint64_t PulseCounter::readPulseCount()
+{
+    if( !_isActive ) return 0;
+    return readTotal() - _base;
+}
+
+// Counting continues through a clear so no edge is lost while the timer would
+// be stopped
+void PulseCounter::clear()
+{
+    if( !_isActive ) return;
+    _base = readTotal();
+}
+
+// The total count extended by the overflows, an overflow the interrupt has not
+// handled yet is accounted for here
+uint64_t PulseCounter::readTotal()
+{
+    uint64_t total = 0;
+
+    ATOMIC_OPERATION( {
+        uint32_t count = _timer->getCount();
+        uint64_t overflows = _overflows;
+
+        // If the counter wrapped around the first read the second read is
+        // after the wrap
+        if( _timer->overflowPending() ) {
+            count = _timer->getCount();
+            overflows++;
+        }
+        total = ( overflows << _countBits ) + count;
+    } )
+
+    return total;
+}
+
+void PulseCounter::IrqHandler()
+{
+    _overflows++;
+}
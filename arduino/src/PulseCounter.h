@@ -0,0 +1,58 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef PULSECOUNTER_H_
+#define PULSECOUNTER_H_
+
+#include <stdint.h>
+#include "TimerCounter.h"
+#include "EventChannel.h"
+#include "external_interrupts.h"
+
+// Counts edges on a pin in hardware, the EIC line is routed through the event
+// system into the timer so the CPU is only woken when the timer overflows.
+// Counting continues in standby with the EIC and timer on the 32 kHz GCLK1,
+// pulses must then be at least ~61 us wide and ~61 us apart. An even timer
+// counts in 32 bit mode (taking its odd partner), an odd timer in 16 bit mode.
+class PulseCounter
+{
+  public:
+    PulseCounter( TimerCounter *timer );
+    int8_t   begin( uint32_t pin, uint32_t sense = RISING );
+    void     end();
+    uint64_t readPulseCount();
+    void     clear();
+    void     IrqHandler();
+    bool     isActive()
+    {
+        return _isActive;
+    }
+
+  private:
+    TimerCounter *    _timer;
+    EventChannel      _channel;
+    volatile uint32_t _overflows;
+    uint64_t          _base;
+    uint8_t           _countBits;
+    uint32_t          _pin;
+    bool              _isActive;
+    bool              _eicWasLowPower;
+    uint64_t          readTotal();
+};
+
+#endif /* PULSECOUNTER_H_ */
@@ -16,11 +16,13 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <string.h>
 #include "sam.h"
 #include "RTC.h"
 #include "clocks.h"
 #include "sleep.h"
 #include "atomic.h"
+#include "core_debug.h"
 
 // Minimum step length in delay for us to sleep during the delay
 #define RTC_MIN_DELAY_LEN_TO_SLEEP 32
@@ -31,25 +33,65 @@
 #define RTC_MAX_STEPS 0x1FFFFFFFFFFFF
 #define RTC_SYNC_BUSY ( RTC->MODE1.STATUS.bit.SYNCBUSY )
 #define RTC_WAIT_SYNC while( RTC_SYNC_BUSY )
+
+// Requests continuous reads of the count, which is valid once SYNCBUSY clears
+#define RTC_REQUEST_READS \
+    RTC->MODE1.READREQ.reg |= RTC_READREQ_RCONT | RTC_READREQ_RREQ;
 #define RTC_SET_READS                          \
     {                                          \
         ATOMIC_OPERATION( {                    \
             if( RTC_SYNC_BUSY ) RTC_WAIT_SYNC; \
-            RTC->MODE1.READREQ.bit.RCONT = 1;  \
-            RTC->MODE1.READREQ.bit.RREQ = 1;   \
+            RTC_REQUEST_READS                  \
         } )                                    \
     }
 
+// Writing to a compare register clears automatic reads, they are requested
+// again in the same critical section. The count is valid again ~10 RTC cycles
+// later, nothing waits for that here, stepsRTC() waits for it when read
+// before then. A sync still pending from an earlier write is waited out
+// before interrupts are masked.
+#define RTC_SET_COMPARE( n, steps )                                      \
+    {                                                                    \
+        RTC_WAIT_SYNC;                                                   \
+        ATOMIC_OPERATION( {                                              \
+            if( RTC_SYNC_BUSY ) RTC_WAIT_SYNC;                           \
+            RTC->MODE1.COMP[n].reg = ( uint16_t )( ( steps ) &           \
+                                                   RTC_STEPS_OVERFLOW ); \
+            RTC_REQUEST_READS                                            \
+        } )                                                              \
+    }
+
+typedef struct
+{
+    uint64_t deadline;
+    void ( *callback )( void * );
+    void *  ctx;
+    uint8_t slot;
+} RTCAlarm_t;
+
 void RTC_IRQHandler();
 
-volatile uint8_t               _insideDelaySetup = 0;
 volatile uint64_t              _rtcOverFlows;
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
 volatile RTCSteps_Debug_t      _stepsDebug = {0, 0, 0, 0, 0};
 volatile DelayRTCSteps_Debug_t _delayStepsDebug = {0, 0, 0, 0, 0, 0};
 volatile RTCIRQ_Debug_t        _rtcIrqDebug = {0, 0, 0, 0};
+#endif
 void ( *userOverFlowISR )() = 0;
+void ( *userCompareISR )() = 0;
 int ( *userIdleTaskHasWork )() = 0;
 
+// Pending alarms as a min-heap on the deadline, and the heap position and id
+// of each alarm slot (0 when free) so alarms can be cancelled by id
+static RTCAlarm_t       _alarmHeap[RTC_MAX_ALARMS];
+static int8_t           _alarmPos[RTC_MAX_ALARMS];
+static int16_t          _alarmIds[RTC_MAX_ALARMS];
+static uint8_t          _alarmCount = 0;
+static uint16_t         _alarmSeq = 0;
+static volatile uint8_t _alarmDispatching = 0;
+
+static void armAlarmCompare();
+
 // Initializes the RTC with a 32768 Hz input clock source. The resolution of the
 //  RTC module is therefore 30.5 uS. The RTC overflow interrupt is set to
 //  trigger once ever 32768 clock cycles which is one overflow per second.
@@ -74,6 +116,7 @@ void initRTC()
         RTC->MODE1.PER.reg = RTC_STEPS_OVERFLOW;
     } )
 
+    RTC->MODE1.EVCTRL.reg = RTC_PERIODIC_EVENTS;
     RTC->MODE1.INTENSET.bit.OVF = 1;
     NVIC_EnableIRQ( RTC_IRQn );
 
@@ -103,36 +146,39 @@ void disableRTC()
 
 uint64_t stepsRTC()
 {
-    _stepsDebug.inside = 1;
-    _stepsDebug.overFlowCalled = 0;
+    uint32_t countReg, flags;
+    uint64_t steps;
 
-    // If we are inside delayRTCSteps setup we need to enable continuous reads
-    if( _insideDelaySetup ) {
-        RTC_SET_READS
-    }
+    CORE_DEBUG_COUNT( _stepsDebug.inside = 1; _stepsDebug.overFlowCalled = 0; )
 
     // If we are within 6 RTC steps of the overflow value we need to wait until
     // the overflow is complete to avoid a stale register and overflow count
     // value
     do {
 
-        // Get the count and interrupt flag register values
-        _stepsDebug.countReg = RTC->MODE1.COUNT.reg;
-        _stepsDebug.rtcFlags = RTC->MODE1.INTFLAG.reg;
+        // Get the count and interrupt flag register values, the count is
+        // stale until a pending read request has synchronized
+        if( RTC_SYNC_BUSY ) RTC_WAIT_SYNC;
+        countReg = RTC->MODE1.COUNT.reg;
+        flags = RTC->MODE1.INTFLAG.reg;
 
         // Check it the overflow interrupt was triggered and call it
-        if( _stepsDebug.rtcFlags & RTC_MODE1_INTFLAG_OVF ) {
+        if( flags & RTC_MODE1_INTFLAG_OVF ) {
             RTC_SET_READS
             RTC_IRQHandler();
-            _stepsDebug.overFlowCalled = 1;
+            CORE_DEBUG_COUNT( _stepsDebug.overFlowCalled = 1; )
             continue;
         }
-    } while( _stepsDebug.countReg >= ( RTC_STEPS_OVERFLOW - 6 ) );
+    } while( countReg >= ( RTC_STEPS_OVERFLOW - 6 ) );
 
     // Return the total overflows with the current count register value
-    _stepsDebug.rtnSteps = ( _rtcOverFlows << 15 ) | _stepsDebug.countReg;
-    _stepsDebug.inside = 0;
-    return _stepsDebug.rtnSteps;
+    steps = ( _rtcOverFlows << 15 ) | countReg;
+
+    CORE_DEBUG_TRACE( _stepsDebug.countReg = countReg;
+                      _stepsDebug.rtcFlags = flags;
+                      _stepsDebug.rtnSteps = steps; )
+    CORE_DEBUG_COUNT( _stepsDebug.inside = 0; )
+    return steps;
 }
 
 uint64_t secondsRTC()
@@ -147,17 +193,19 @@ void delayRTCSteps( uint64_t steps )
 
 void delayRTCStepsIdle( uint64_t steps, void ( *idleFunc )() )
 {
-    // Set the debug values to the step length to conserve the values
-    _delayStepsDebug.inside = 1;
-    _delayStepsDebug.steps = steps;
-    _delayStepsDebug.sleepCounter = 0;
+    uint64_t start, cnt;
+    int64_t  remaining;
+
+    CORE_DEBUG_COUNT( _delayStepsDebug.inside = 1;
+                      _delayStepsDebug.sleepCounter = 0; )
+    CORE_DEBUG_TRACE( _delayStepsDebug.steps = steps; )
 
     // Set the start and cnt values to current steps
-    _delayStepsDebug.cnt = _delayStepsDebug.start = stepsRTC();
+    cnt = start = stepsRTC();
+    CORE_DEBUG_TRACE( _delayStepsDebug.start = start; )
 
     // Remain here while the delta between cnt and start is less than steps
-    while( ( _delayStepsDebug.cnt - _delayStepsDebug.start ) <
-           _delayStepsDebug.steps ) {
+    while( ( cnt - start ) < steps ) {
 
         // Check to see if the idle task can be called
         if( userIdleTaskHasWork && idleFunc ) {
@@ -165,11 +213,9 @@ void delayRTCStepsIdle( uint64_t steps, void ( *idleFunc )() )
             // Only call the idle task if we have a delay longer than 1 ms, and
             // if we have actual work to do
             if( userIdleTaskHasWork() &&
-                ( _delayStepsDebug.steps -
-                      ( _delayStepsDebug.cnt - _delayStepsDebug.start ) >
-                  RTC_MIN_DELAY_LEN_TO_SLEEP ) ) {
+                ( steps - ( cnt - start ) > RTC_MIN_DELAY_LEN_TO_SLEEP ) ) {
                 idleFunc();
-                _delayStepsDebug.cnt = stepsRTC();
+                cnt = stepsRTC();
                 continue;
             }
         }
@@ -178,59 +224,33 @@ void delayRTCStepsIdle( uint64_t steps, void ( *idleFunc )() )
         if( !__get_PRIMASK() && NVIC_GetEnableIRQ( RTC_IRQn ) ) {
 
             // Check to see if the delay length is long enough for us to sleep
-            _delayStepsDebug.internalDelay = ( int64_t )(
-                ( _delayStepsDebug.start + _delayStepsDebug.steps ) -
-                _delayStepsDebug.cnt );
+            remaining = ( int64_t )( ( start + steps ) - cnt );
+            CORE_DEBUG_TRACE( _delayStepsDebug.internalDelay = remaining; )
 
             // If it is, lets go to sleep
-            if( _delayStepsDebug.internalDelay > RTC_MIN_DELAY_LEN_TO_SLEEP ) {
-
-                // Set the soft lock
-                _insideDelaySetup = 1;
-                _delayStepsDebug.sleepCounter++;
-
-                // Clear the compare interrupt flag
-                RTC->MODE1.INTFLAG.reg = RTC_MODE1_INTFLAG_CMP0;
+            if( remaining > RTC_MIN_DELAY_LEN_TO_SLEEP ) {
 
-                // Account for the ~10 RTC cycles it takes to re-enable reads at
-                // the end of this section
-                ATOMIC_OPERATION( {
-                    if( RTC_SYNC_BUSY ) RTC_WAIT_SYNC;
-                    RTC->MODE1.COMP[0].reg = ( uint16_t )(
-                        ( ( _delayStepsDebug.internalDelay -
-                            RTC_CNT_READ_ENABLE_DELAY ) +
-                          ( _delayStepsDebug.cnt & RTC_STEPS_OVERFLOW ) ) &
-                        RTC_STEPS_OVERFLOW );
-                } )
+                CORE_DEBUG_COUNT( _delayStepsDebug.sleepCounter++; )
 
-                // Enable the compare interrupt
-                RTC->MODE1.INTENSET.bit.CMP0 = 1;
+                // Wake on an alarm, account for the ~10 RTC cycles it takes to
+                // re-enable reads once the alarm has fired
+                int16_t alarm = rtcAlarmAt(
+                    start + steps - RTC_CNT_READ_ENABLE_DELAY, 0, 0 );
 
                 // Sleep the CPU
-                sleepCPU( _deep_sleep );
-
-                // Disable the compare interrupt, keep the overflow interrupt
-                // enabled
-                uint32_t b = RTC->MODE1.INTENSET.reg;
-                if( b & RTC_MODE1_INTENSET_CMP0 ) {
-                    b &= ~RTC_MODE1_INTENCLR_OVF;
-                    RTC->MODE1.INTENCLR.reg = b;
-                }
-
-                // Writing to the compare register clears automatic reads,
-                // re-enable automatic reads. Takes ~10 RTC cycles
-                RTC_SET_READS
-
-                // Release the soft lock
-                _insideDelaySetup = 0;
+                if( alarm != -1 ) sleepCPU( _deep_sleep );
+
+                // Something else may have woken us up
+                rtcAlarmCancel( alarm );
             }
         }
 
         // Grab the new count coming out of sleep
-        _delayStepsDebug.cnt = stepsRTC();
+        cnt = stepsRTC();
+        CORE_DEBUG_TRACE( _delayStepsDebug.cnt = cnt; )
     }
 
-    _delayStepsDebug.inside = 0;
+    CORE_DEBUG_COUNT( _delayStepsDebug.inside = 0; )
 }
 
 void registerOverflowISR( void ( *ISRFunc )() )
@@ -243,9 +263,235 @@ void registerIdleTaskHasWork( int ( *Func )() )
     userIdleTaskHasWork = Func;
 }
 
+void registerCompareISR( void ( *ISRFunc )() )
+{
+    userCompareISR = ISRFunc;
+}
+
+// Arms compare 1 to match when stepsRTC() reaches atSteps. The compare only
+// holds the step within the second, it matches once every second until it is
+// disarmed so the compare ISR must check the full step count itself. Returns
+// -1 without arming if atSteps is too close to be matched.
+int8_t armCompareRTC( uint64_t atSteps )
+{
+    RTC_SET_COMPARE( 1, atSteps )
+    RTC->MODE1.INTFLAG.reg = RTC_MODE1_INTFLAG_CMP1;
+    RTC->MODE1.INTENSET.reg = RTC_MODE1_INTENSET_CMP1;
+
+    if( atSteps < stepsRTC() + RTC_COMPARE_MIN_LEAD ) {
+        disarmCompareRTC();
+        return -1;
+    }
+    return 0;
+}
+
+void disarmCompareRTC()
+{
+    RTC->MODE1.INTENCLR.reg = RTC_MODE1_INTENCLR_CMP1;
+    RTC->MODE1.INTFLAG.reg = RTC_MODE1_INTFLAG_CMP1;
+}
+
+static void swapAlarms( uint8_t a, uint8_t b )
+{
+    RTCAlarm_t tmp = _alarmHeap[a];
+
+    _alarmHeap[a] = _alarmHeap[b];
+    _alarmHeap[b] = tmp;
+    _alarmPos[_alarmHeap[a].slot] = a;
+    _alarmPos[_alarmHeap[b].slot] = b;
+}
+
+static void siftAlarmUp( uint8_t i )
+{
+    while( i > 0 ) {
+        uint8_t parent = ( i - 1 ) >> 1;
+        if( _alarmHeap[parent].deadline <= _alarmHeap[i].deadline ) break;
+        swapAlarms( i, parent );
+        i = parent;
+    }
+}
+
+static void siftAlarmDown( uint8_t i )
+{
+    for( ;; ) {
+        uint8_t child = ( i << 1 ) + 1;
+        if( child >= _alarmCount ) break;
+        if( child + 1 < _alarmCount &&
+            _alarmHeap[child + 1].deadline < _alarmHeap[child].deadline )
+            child++;
+        if( _alarmHeap[i].deadline <= _alarmHeap[child].deadline ) break;
+        swapAlarms( i, child );
+        i = child;
+    }
+}
+
+static void removeAlarm( uint8_t i )
+{
+    uint8_t last = --_alarmCount;
+    uint8_t slot = _alarmHeap[last].slot;
+
+    _alarmPos[_alarmHeap[i].slot] = -1;
+    _alarmIds[_alarmHeap[i].slot] = 0;
+    if( i == last ) return;
+
+    // Fill the hole with the last alarm and restore the heap order around it
+    _alarmHeap[i] = _alarmHeap[last];
+    _alarmPos[slot] = i;
+    siftAlarmUp( i );
+    siftAlarmDown( _alarmPos[slot] );
+}
+
+// Programs compare 0 for the earliest alarm. An alarm closer than the compare
+// can be matched is moved out to the closest step that can be, and the compare
+// is re-programmed if the count passed it while it was written. Only the
+// compare write is atomic, the syncs are waited for with interrupts enabled
+// unless the caller already masked them.
+static void armAlarmCompare()
+{
+    uint64_t target;
+    uint8_t  armed;
+
+    do {
+        armed = 0;
+        RTC_WAIT_SYNC;
+        ATOMIC_OPERATION( {
+            if( _alarmCount == 0 )
+                RTC->MODE1.INTENCLR.reg = RTC_MODE1_INTENCLR_CMP0;
+            else {
+                target = stepsRTC() + RTC_COMPARE_MIN_LEAD;
+                if( _alarmHeap[0].deadline > target )
+                    target = _alarmHeap[0].deadline;
+
+                RTC_SET_COMPARE( 0, target )
+                RTC->MODE1.INTFLAG.reg = RTC_MODE1_INTFLAG_CMP0;
+                RTC->MODE1.INTENSET.reg = RTC_MODE1_INTENSET_CMP0;
+                armed = 1;
+            }
+        } )
+    } while( armed && stepsRTC() >= target );
+}
+
+// Calls every alarm that is due, from the RTC interrupt. A callback may set new
+// alarms, a nested call through stepsRTC() is left to the outer loop.
+static void dispatchAlarms()
+{
+    if( _alarmDispatching ) return;
+    _alarmDispatching = 1;
+
+    while( _alarmCount && _alarmHeap[0].deadline <= stepsRTC() ) {
+        RTCAlarm_t alarm = _alarmHeap[0];
+
+        removeAlarm( 0 );
+        if( alarm.callback ) alarm.callback( alarm.ctx );
+    }
+    armAlarmCompare();
+
+    _alarmDispatching = 0;
+}
+
+// Calls callback with ctx from the RTC interrupt once stepsRTC() reaches
+// atSteps, a step that has already passed fires right away. The callback may be
+// 0 to only wake the CPU. Returns the alarm id, or -1 if all RTC_MAX_ALARMS
+// alarms are pending.
+int16_t rtcAlarmAt( uint64_t atSteps, void ( *callback )( void * ), void *ctx )
+{
+    int16_t id = -1;
+    uint8_t rearm = 0;
+
+    ATOMIC_OPERATION( {
+        for( uint8_t slot = 0; slot < RTC_MAX_ALARMS; slot++ ) {
+            if( _alarmIds[slot] != 0 ) continue;
+
+            // The sequence in the upper bits keeps a stale id from cancelling
+            // a later alarm in the same slot, it is never 0 so neither is an id
+            _alarmSeq = ( _alarmSeq & RTC_ALARM_SEQ_MASK ) + 1;
+            id = ( int16_t )( ( _alarmSeq << RTC_ALARM_SLOT_BITS ) | slot );
+            _alarmIds[slot] = id;
+
+            _alarmHeap[_alarmCount].deadline = atSteps;
+            _alarmHeap[_alarmCount].callback = callback;
+            _alarmHeap[_alarmCount].ctx = ctx;
+            _alarmHeap[_alarmCount].slot = slot;
+            _alarmPos[slot] = _alarmCount;
+            siftAlarmUp( _alarmCount++ );
+
+            rearm = ( _alarmPos[slot] == 0 && !_alarmDispatching );
+            break;
+        }
+    } )
+    if( rearm ) armAlarmCompare();
+
+    return id;
+}
+
+// Returns the deadline of the earliest pending alarm, or 0 if there is none
+uint64_t rtcNextAlarm()
+{
+    uint64_t next = 0;
+
+    ATOMIC_OPERATION( {
+        if( _alarmCount ) next = _alarmHeap[0].deadline;
+    } )
+    return next;
+}
+
+// Cancels a pending alarm, returns -1 if it already fired or was cancelled
+int8_t rtcAlarmCancel( int16_t id )
+{
+    int8_t  rtn = -1;
+    uint8_t rearm = 0;
+    uint8_t slot = id & ( ( 1 << RTC_ALARM_SLOT_BITS ) - 1 );
+
+    if( id <= 0 ) return -1;
+
+    ATOMIC_OPERATION( {
+        if( _alarmIds[slot] == id ) {
+            uint8_t first = ( _alarmPos[slot] == 0 );
+            removeAlarm( _alarmPos[slot] );
+            rearm = ( first && !_alarmDispatching );
+            rtn = 0;
+        }
+    } )
+    if( rearm ) armAlarmCompare();
+
+    return rtn;
+}
+
+// Programs the frequency correction in units of 1 / 2^20 (~0.954 ppm), a
+// positive value speeds the RTC up. Values beyond RTC_FREQCORR_MAX are clamped.
+void setFreqCorrRTC( int16_t units )
+{
+    uint8_t reg;
+
+    if( units > RTC_FREQCORR_MAX ) units = RTC_FREQCORR_MAX;
+    if( units < -RTC_FREQCORR_MAX ) units = -RTC_FREQCORR_MAX;
+
+    if( units < 0 )
+        reg = RTC_FREQCORR_SIGN | RTC_FREQCORR_VALUE( -units );
+    else
+        reg = RTC_FREQCORR_VALUE( units );
+
+    // Like the compare registers, the write clears automatic reads
+    RTC_WAIT_SYNC;
+    ATOMIC_OPERATION( {
+        if( RTC_SYNC_BUSY ) RTC_WAIT_SYNC;
+        RTC->MODE1.FREQCORR.reg = reg;
+        RTC_REQUEST_READS
+    } )
+}
+
+int16_t getFreqCorrRTC()
+{
+    uint8_t reg = RTC->MODE1.FREQCORR.reg;
+    int16_t units = reg & RTC_FREQCORR_VALUE_Msk;
+
+    return ( reg & RTC_FREQCORR_SIGN ) ? -units : units;
+}
+
 void getRTCDebugInfo( RTCSteps_Debug_t *steps, DelayRTCSteps_Debug_t *dSteps,
                       RTCIRQ_Debug_t *irqSteps )
 {
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
     steps->countReg = _stepsDebug.countReg;
     steps->inside = _stepsDebug.inside;
     steps->overFlowCalled = _stepsDebug.overFlowCalled;
@@ -263,33 +509,56 @@ void getRTCDebugInfo( RTCSteps_Debug_t *steps, DelayRTCSteps_Debug_t *dSteps,
     irqSteps->irqFlags = _rtcIrqDebug.irqFlags;
     irqSteps->maxOVF = _rtcIrqDebug.maxOVF;
     irqSteps->userISRCalled = _rtcIrqDebug.userISRCalled;
+#else
+    memset( steps, 0, sizeof( RTCSteps_Debug_t ) );
+    memset( dSteps, 0, sizeof( DelayRTCSteps_Debug_t ) );
+    memset( irqSteps, 0, sizeof( RTCIRQ_Debug_t ) );
+#endif
 }
 
 void RTC_IRQHandler()
 {
-    _rtcIrqDebug.inside = 1;
-    _rtcIrqDebug.irqFlags = RTC->MODE1.INTFLAG.reg;
-    _rtcIrqDebug.maxOVF = 0;
-    _rtcIrqDebug.userISRCalled = 0;
+    uint32_t flags;
 
-    // RTC can wake the processor, ensure we exit sleep properly
-    exitSleep();
+    CORE_DEBUG_COUNT( _rtcIrqDebug.inside = 1; _rtcIrqDebug.maxOVF = 0;
+                      _rtcIrqDebug.userISRCalled = 0; )
 
-    // Handle an overflow interrupt, call the user enabled handler if there is
-    // one
-    if( _rtcIrqDebug.irqFlags & RTC_MODE1_INTFLAG_OVF ) {
+    // Clear the flags and count the overflow together before any handler runs,
+    // a handler calling stepsRTC() must not see the overflow a second time
+    ATOMIC_OPERATION( {
+        flags = RTC->MODE1.INTFLAG.reg;
+        RTC->MODE1.INTFLAG.reg = flags;
 
-        if( ( ++_rtcOverFlows ) > RTC_MAX_STEPS ) {
-            _rtcIrqDebug.maxOVF = 1;
+        if( ( flags & RTC_MODE1_INTFLAG_OVF ) &&
+            ( ++_rtcOverFlows ) > RTC_MAX_STEPS ) {
+            CORE_DEBUG_COUNT( _rtcIrqDebug.maxOVF = 1; )
             _rtcOverFlows = 0;
         }
+    } )
+    CORE_DEBUG_TRACE( _rtcIrqDebug.irqFlags = flags; )
 
+    // RTC can wake the processor, ensure we exit sleep properly
+    exitSleep();
+
+    // Call the user overflow handler if there is one
+    if( flags & RTC_MODE1_INTFLAG_OVF ) {
         if( userOverFlowISR != 0 ) {
-            _rtcIrqDebug.userISRCalled = 1;
+            CORE_DEBUG_COUNT( _rtcIrqDebug.userISRCalled = 1; )
             userOverFlowISR();
         }
     }
 
-    RTC->MODE1.INTFLAG.reg = _rtcIrqDebug.irqFlags;
-    _rtcIrqDebug.inside = 0;
+    // Handle a compare 1 match, see armCompareRTC()
+    if( ( flags & RTC_MODE1_INTFLAG_CMP1 ) &&
+        ( RTC->MODE1.INTENSET.reg & RTC_MODE1_INTENSET_CMP1 ) &&
+        userCompareISR != 0 ) {
+        userCompareISR();
+    }
+
+    // The compare matches once a second at the programmed step, the alarm
+    // deadlines decide what is due
+    if( ( flags & RTC_MODE1_INTFLAG_CMP0 ) && _alarmCount )
+        dispatchAlarms();
+
+    CORE_DEBUG_COUNT( _rtcIrqDebug.inside = 0; )
 }
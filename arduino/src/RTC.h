@@ -24,12 +24,42 @@
 #define RTC_STEPS_OVERFLOW 0x7FFF
 #define RTC_OVF_MSB 0x4000
 
+// Closest step ahead of the count that armCompareRTC() can still match
+#define RTC_COMPARE_MIN_LEAD 12
+
+// Alarms that can be pending at once, see rtcAlarmAt(). Alarm ids hold the
+// slot in the low bits and a sequence number above it.
+#ifndef RTC_MAX_ALARMS
+#define RTC_MAX_ALARMS 8
+#endif
+#define RTC_ALARM_SLOT_BITS 4
+#define RTC_ALARM_SEQ_MASK 0x3FF
+#if RTC_MAX_ALARMS > ( 1 << RTC_ALARM_SLOT_BITS )
+#error "RTC_MAX_ALARMS must fit in RTC_ALARM_SLOT_BITS"
+#endif
+
+// Periodic event outputs initRTC() enables, EVCTRL is enable-protected so they
+// can't be switched on later. An event only reaches users routed to it, see
+// EVENT_GEN_RTC_PER().
+#ifndef RTC_PERIODIC_EVENTS
+#define RTC_PERIODIC_EVENTS RTC_MODE1_EVCTRL_PEREO_Msk
+#endif
+
+// Largest frequency correction magnitude, see setFreqCorrRTC()
+#define RTC_FREQCORR_MAX 127
+
+// Largest step count rtcFreqCorrection() scales without shifting it down
+#define RTC_FREQCORR_SCALE_MAX ( 1ull << 52 )
+
 // Rough operations a faster but less accurate
 #define RTC_ROUGH_STEPS_TO_MILLIS( x ) ( x >> 5 )
 #define RTC_ROUGH_MILLIS_TO_STEPS( x ) ( x << 5 )
 
 // Exact operations are slower but more accurate
-#define RTC_EXACT_STEPS_TO_MILLIS( x ) ( ( x * 1000 ) >> 15 )
+// steps * 1000 / 2^15 reduces to steps * 125 / 2^12, split at bit 12 so the
+// low part can't overflow
+#define RTC_EXACT_STEPS_TO_MILLIS( x ) \
+    ( ( ( ( x ) >> 12 ) * 125 ) + ( ( ( ( x ) & 0xFFF ) * 125 ) >> 12 ) )
 #define RTC_EXACT_MILLIS_TO_STEPS( x ) ( ( x << 15 ) / 1000 )
 
 #ifdef __cplusplus
@@ -64,6 +94,17 @@ void     delayRTCSteps( uint64_t steps );
 void     delayRTCStepsIdle( uint64_t steps, void ( *idleFunc )() );
 void     registerOverflowISR( void ( *ISRFunc )() );
 void     registerIdleTaskHasWork( int ( *Func )() );
+void     registerCompareISR( void ( *ISRFunc )() );
+int8_t   armCompareRTC( uint64_t atSteps );
+void     disarmCompareRTC();
+int16_t  rtcAlarmAt( uint64_t atSteps, void ( *callback )( void * ),
+                     void *ctx );
+int8_t   rtcAlarmCancel( int16_t id );
+uint64_t rtcNextAlarm();
+void     setFreqCorrRTC( int16_t units );
+int16_t  getFreqCorrRTC();
+int16_t  rtcFreqCorrection( int16_t current, uint64_t measured,
+                            uint64_t expected );
 void getRTCDebugInfo( RTCSteps_Debug_t *steps, DelayRTCSteps_Debug_t *dSteps,
                       RTCIRQ_Debug_t *irqSteps );
 
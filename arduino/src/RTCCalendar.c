@@ -0,0 +1,299 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "RTCCalendar.h"
+#include "RTC.h"
+#include "atomic.h"
+
+// Longest forward jump that still walks the cached date a day at a time
+// instead of converting from scratch
+#define RTC_CALENDAR_MAX_WALK_DAYS 7
+
+typedef struct
+{
+    uint32_t epoch; // Next time the alarm fires
+    void ( *callback )( void * );
+    void *   ctx;
+    int16_t  rtcId; // rtcAlarmAt() id while armed, 0 otherwise
+    uint8_t  used, daily;
+} RTCCalendarAlarm_t;
+
+// The epoch is kept as the RTC step count at a whole UNIX second, which makes
+// any step count a shift away from UNIX time. Until rtcSetEpoch() is called
+// the epoch counts from power up.
+static uint64_t _epochSteps = 0;
+static uint32_t _epochSeconds = 0;
+
+// Date of the last conversion and the epoch of its midnight, later times on
+// the same or the next few days are derived from it without dividing
+static RTCDate_t _cachedDate = {1970, 1, 1, 0, 0, 0, 4};
+static uint32_t  _cachedDayStart = 0;
+
+static RTCCalendarAlarm_t _calendarAlarms[RTC_CALENDAR_ALARMS];
+
+static void calendarAlarmFired( void *ctx );
+
+static uint8_t daysInMonth( uint16_t year, uint8_t month )
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30,
+                                     31, 31, 30, 31, 30, 31};
+
+    if( month == 2 && !( year & 3 ) && ( year % 100 || !( year % 400 ) ) )
+        return 29;
+    return days[month - 1];
+}
+
+// Days since 1970-01-01 to a civil date and back, H. Hinnant's
+// chrono-compatible low-level date algorithms
+static void daysToCivil( uint32_t days, RTCDate_t *date )
+{
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    uint32_t doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    uint32_t mp = ( 5 * doy + 2 ) / 153;
+
+    date->day = ( uint8_t )( doy - ( 153 * mp + 2 ) / 5 + 1 );
+    date->month = ( uint8_t )( mp < 10 ? mp + 3 : mp - 9 );
+    date->year = ( uint16_t )( yoe + era * 400 + ( date->month <= 2 ) );
+    date->weekday = ( uint8_t )( ( days + 4 ) % 7 );
+}
+
+static uint32_t civilToDays( const RTCDate_t *date )
+{
+    uint32_t y = date->year - ( date->month <= 2 );
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t mp = date->month > 2 ? date->month - 3 : date->month + 9;
+    uint32_t doy = ( 153 * mp + 2 ) / 5 + date->day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+static void nextDay( RTCDate_t *date )
+{
+    if( ++date->weekday > 6 ) date->weekday = 0;
+    if( ++date->day > daysInMonth( date->year, date->month ) ) {
+        date->day = 1;
+        if( ++date->month > 12 ) {
+            date->month = 1;
+            date->year++;
+        }
+    }
+}
+
+// The first time after now at the time of day of a daily alarm, so a daily
+// alarm never has days to catch up on
+static uint32_t nextDailyEpoch( uint32_t alarmEpoch, uint32_t now )
+{
+    uint32_t at = now - now % RTC_SECONDS_PER_DAY +
+                  alarmEpoch % RTC_SECONDS_PER_DAY;
+
+    if( at <= now ) at += RTC_SECONDS_PER_DAY;
+    return at;
+}
+
+void rtcSetEpoch( uint32_t epoch )
+{
+    ATOMIC_OPERATION( {
+        _epochSteps = stepsRTC();
+        _epochSeconds = epoch;
+
+        // The armed alarms were placed with the old epoch
+        for( uint8_t i = 0; i < RTC_CALENDAR_ALARMS; i++ ) {
+            RTCCalendarAlarm_t *alarm = &_calendarAlarms[i];
+            if( !alarm->used ) continue;
+            rtcAlarmCancel( alarm->rtcId );
+            if( alarm->daily )
+                alarm->epoch = nextDailyEpoch( alarm->epoch, epoch );
+            alarm->rtcId = rtcAlarmAt( rtcEpochToSteps( alarm->epoch ),
+                                       calendarAlarmFired, alarm );
+        }
+    } )
+}
+
+uint32_t rtcEpoch()
+{
+    return rtcStepsToEpoch( stepsRTC() );
+}
+
+uint32_t rtcStepsToEpoch( uint64_t steps )
+{
+    uint64_t base;
+    uint32_t seconds;
+
+    ATOMIC_OPERATION( {
+        base = _epochSteps;
+        seconds = _epochSeconds;
+    } )
+
+    // Round toward earlier times on both sides of the epoch
+    if( steps >= base ) return seconds + ( uint32_t )( ( steps - base ) >> 15 );
+    return seconds - ( uint32_t )( ( base - steps + 0x7FFF ) >> 15 );
+}
+
+uint64_t rtcEpochToSteps( uint32_t epoch )
+{
+    uint64_t base;
+    uint32_t seconds;
+
+    ATOMIC_OPERATION( {
+        base = _epochSteps;
+        seconds = _epochSeconds;
+    } )
+
+    if( epoch >= seconds )
+        return base + ( (uint64_t)( epoch - seconds ) << 15 );
+
+    // Before the RTC started counting, the earliest step will do
+    uint64_t back = (uint64_t)( seconds - epoch ) << 15;
+    return back < base ? base - back : 0;
+}
+
+void rtcEpochToDate( uint32_t epoch, RTCDate_t *date )
+{
+    uint32_t secOfDay, rem;
+
+    ATOMIC_OPERATION( {
+        // Walk the cached date forward a day at a time for the common case of
+        // a later time, only convert from scratch when jumping around
+        if( epoch >= _cachedDayStart &&
+            epoch - _cachedDayStart <
+                RTC_CALENDAR_MAX_WALK_DAYS * RTC_SECONDS_PER_DAY ) {
+            while( epoch - _cachedDayStart >= RTC_SECONDS_PER_DAY ) {
+                _cachedDayStart += RTC_SECONDS_PER_DAY;
+                nextDay( &_cachedDate );
+            }
+        }
+        else {
+            uint32_t days = epoch / RTC_SECONDS_PER_DAY;
+            _cachedDayStart = days * RTC_SECONDS_PER_DAY;
+            daysToCivil( days, &_cachedDate );
+        }
+
+        *date = _cachedDate;
+        secOfDay = epoch - _cachedDayStart;
+    } )
+
+    // Reciprocal multiplies, exact for every second of a day
+    date->hour = ( uint8_t )( ( secOfDay * 37283 ) >> 27 );
+    rem = secOfDay - date->hour * 3600;
+    date->minute = ( uint8_t )( ( rem * 34953 ) >> 21 );
+    date->second = ( uint8_t )( rem - date->minute * 60 );
+}
+
+uint32_t rtcDateToEpoch( const RTCDate_t *date )
+{
+    return civilToDays( date ) * RTC_SECONDS_PER_DAY + date->hour * 3600ul +
+           date->minute * 60ul + date->second;
+}
+
+void rtcGetDate( RTCDate_t *date )
+{
+    rtcEpochToDate( rtcEpoch(), date );
+}
+
+// Runs from the RTC interrupt, a daily alarm is placed on its next time after
+// now before its callback runs so the callback may cancel it. Days missed
+// while the alarm couldn't run are skipped, not fired one after another.
+static void calendarAlarmFired( void *ctx )
+{
+    RTCCalendarAlarm_t *alarm = (RTCCalendarAlarm_t *)ctx;
+    void ( *callback )( void * ) = alarm->callback;
+    void *cbCtx = alarm->ctx;
+
+    if( alarm->daily ) {
+        alarm->epoch = nextDailyEpoch( alarm->epoch, rtcEpoch() );
+        alarm->rtcId = rtcAlarmAt( rtcEpochToSteps( alarm->epoch ),
+                                   calendarAlarmFired, alarm );
+    }
+    else {
+        alarm->rtcId = 0;
+        alarm->used = 0;
+    }
+
+    if( callback ) callback( cbCtx );
+}
+
+static int8_t addCalendarAlarm( uint32_t epoch, uint8_t daily,
+                                void ( *callback )( void * ), void *ctx )
+{
+    int8_t rtn = -1;
+
+    ATOMIC_OPERATION( {
+        for( uint8_t i = 0; i < RTC_CALENDAR_ALARMS; i++ ) {
+            RTCCalendarAlarm_t *alarm = &_calendarAlarms[i];
+            if( alarm->used ) continue;
+
+            alarm->rtcId = rtcAlarmAt( rtcEpochToSteps( epoch ),
+                                       calendarAlarmFired, alarm );
+            if( alarm->rtcId == -1 ) break;
+
+            alarm->epoch = epoch;
+            alarm->callback = callback;
+            alarm->ctx = ctx;
+            alarm->daily = daily;
+            alarm->used = 1;
+            rtn = (int8_t)i;
+            break;
+        }
+    } )
+
+    return rtn;
+}
+
+// Returns the alarm handle, or -1 when no calendar or RTC alarm is free. An
+// epoch that has already passed fires right away.
+int8_t rtcCalendarAlarmAt( uint32_t epoch, void ( *callback )( void * ),
+                           void *ctx )
+{
+    return addCalendarAlarm( epoch, 0, callback, ctx );
+}
+
+// Fires every day at the given UTC time of day until cancelled
+int8_t rtcDailyAlarm( uint8_t hour, uint8_t minute, uint8_t second,
+                      void ( *callback )( void * ), void *ctx )
+{
+    if( hour > 23 || minute > 59 || second > 59 ) return -1;
+
+    uint32_t at = nextDailyEpoch( hour * 3600ul + minute * 60ul + second,
+                                  rtcEpoch() );
+
+    return addCalendarAlarm( at, 1, callback, ctx );
+}
+
+int8_t rtcCalendarAlarmCancel( int8_t alarm )
+{
+    int8_t rtn = -1;
+
+    if( alarm < 0 || alarm >= RTC_CALENDAR_ALARMS ) return -1;
+
+    ATOMIC_OPERATION( {
+        RTCCalendarAlarm_t *cal = &_calendarAlarms[(uint8_t)alarm];
+        if( cal->used ) {
+            rtcAlarmCancel( cal->rtcId );
+            cal->rtcId = 0;
+            cal->used = 0;
+            rtn = 0;
+        }
+    } )
+
+    return rtn;
+}
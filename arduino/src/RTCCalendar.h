@@ -0,0 +1,65 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RTCCALENDAR_H_
+#define RTCCALENDAR_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Calendar alarms that can be set at once, each also takes an RTC alarm slot
+// while armed, see rtcAlarmAt()
+#ifndef RTC_CALENDAR_ALARMS
+#define RTC_CALENDAR_ALARMS 4
+#endif
+
+#define RTC_SECONDS_PER_DAY 86400ul
+
+// Broken down UTC time, valid from 1970 through 2105
+typedef struct
+{
+    uint16_t year;
+    uint8_t  month;   // 1 - 12
+    uint8_t  day;     // 1 - 31
+    uint8_t  hour;    // 0 - 23
+    uint8_t  minute;  // 0 - 59
+    uint8_t  second;  // 0 - 59
+    uint8_t  weekday; // 0 - 6, Sunday is 0
+} RTCDate_t;
+
+void     rtcSetEpoch( uint32_t epoch );
+uint32_t rtcEpoch();
+uint32_t rtcStepsToEpoch( uint64_t steps );
+uint64_t rtcEpochToSteps( uint32_t epoch );
+void     rtcEpochToDate( uint32_t epoch, RTCDate_t *date );
+uint32_t rtcDateToEpoch( const RTCDate_t *date );
+void     rtcGetDate( RTCDate_t *date );
+int8_t   rtcCalendarAlarmAt( uint32_t epoch, void ( *callback )( void * ),
+                             void *ctx );
+int8_t   rtcDailyAlarm( uint8_t hour, uint8_t minute, uint8_t second,
+                        void ( *callback )( void * ), void *ctx );
+int8_t   rtcCalendarAlarmCancel( int8_t alarm );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTCCALENDAR_H_ */
@@ -0,0 +1,188 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "RTCCalibration.h"
+
+typedef struct
+{
+    uint16_t key;
+    int16_t  correction;
+    uint16_t check;
+} RTCCalRecord_t;
+
+static RTCCalibration *_activeCalibration = NULL;
+
+static void calibrationISR()
+{
+    if( _activeCalibration != NULL ) _activeCalibration->IrqHandler();
+}
+
+RTCCalibration::RTCCalibration()
+{
+    _firstEdge = _lastEdge = 0;
+    _edges = 0;
+    _pulses = 0;
+    _errorPPB = 0;
+    _correction = 0;
+    _measured = false;
+}
+
+// Counts RTC steps across pulses periods of a 1 PPS signal on the pin, each
+// step of timing error is 1 / ( pulses * 32768 ) of rate error so 64 pulses
+// resolve ~0.5 ppm. The CPU idles between edges. Returns -1 if the pin can't
+// interrupt, another measurement is running or the pulses don't arrive within
+// timeoutMs.
+int8_t RTCCalibration::measurePPS( uint32_t pin, uint16_t pulses,
+                                   uint32_t timeoutMs )
+{
+    if( pulses == 0 || _activeCalibration != NULL ) return -1;
+
+    _edges = 0;
+    _pulses = pulses;
+    _activeCalibration = this;
+    attachInterrupt( pin, calibrationISR, RISING );
+
+    uint32_t st = millis();
+    while( _edges <= _pulses && millis() - st < timeoutMs ) sleepCPU( _cpu );
+
+    detachInterrupt( pin );
+    _activeCalibration = NULL;
+    if( _edges <= _pulses ) return -1;
+
+    finish( _lastEdge - _firstEdge, (uint64_t)_pulses << 15 );
+    return 0;
+}
+
+// Counts CPU ticks across seconds of RTC steps, refHz is the true CPU clock
+// (SystemCoreClock when 0). The result is only as good as the CPU clock, the
+// DFLL in open loop or OSC8M are ~1000x worse than a crystal so this is meant
+// for a core clock from an external reference. Busy waits for the whole
+// measurement, returns -1 if SysTick restarted part way.
+int8_t RTCCalibration::measureCPUClock( uint16_t seconds, uint32_t refHz )
+{
+    uint64_t steps = (uint64_t)seconds << 15;
+    uint64_t st, now, cpuStart, cpuEnd;
+
+    if( seconds == 0 ) return -1;
+    if( refHz == 0 ) refHz = SystemCoreClock;
+
+    // Start and end right on a step edge so the count covers whole steps
+    st = stepsRTC();
+    do {
+        now = stepsRTC();
+    } while( now == st );
+    cpuStart = getCPUTicks();
+    uint32_t epoch = sysTickEpoch();
+
+    st = now;
+    do {
+        now = stepsRTC();
+    } while( now - st < steps );
+    cpuEnd = getCPUTicks();
+
+    if( sysTickEpoch() != epoch ) return -1;
+
+    // steps / 32768 seconds passed on the RTC, ( cpuEnd - cpuStart ) / refHz
+    // seconds really passed, both scaled by 32768 * refHz without the power of
+    // two the two share
+    uint8_t shared = 0;
+    while( shared < 15 && !( refHz & 1 ) ) {
+        refHz >>= 1;
+        shared++;
+    }
+    finish( steps * refHz, ( cpuEnd - cpuStart ) << ( 15 - shared ) );
+    return 0;
+}
+
+// Programs the measured correction, returns -1 if nothing was measured or the
+// error is beyond what FREQCORR can cancel (it is then only partly corrected)
+int8_t RTCCalibration::apply()
+{
+    if( !_measured ) return -1;
+
+    setFreqCorrRTC( _correction );
+    if( _correction > RTC_FREQCORR_MAX || _correction < -RTC_FREQCORR_MAX )
+        return -1;
+    return 0;
+}
+
+// Saves the correction currently programmed and commits it to flash, returns
+// an EEEPROM_ERR code
+int RTCCalibration::save( EEEPROM &eeprom, int addr )
+{
+    RTCCalRecord_t rec;
+
+    rec.key = RTC_CAL_RECORD_KEY;
+    rec.correction = getFreqCorrRTC();
+    rec.check = ~(uint16_t)rec.correction;
+
+    int err = eeprom.write( addr, &rec, sizeof( rec ) );
+    if( err != EEEPROM_ERR_OK || !eeprom.hasChange() ) return err;
+    return eeprom.commit();
+}
+
+// Programs a correction saved by save(), returns an EEEPROM_ERR code or
+// RTC_CAL_ERR_NO_RECORD if there is no valid record at addr
+int RTCCalibration::load( EEEPROM &eeprom, int addr )
+{
+    RTCCalRecord_t rec;
+
+    int err = eeprom.read( addr, &rec, sizeof( rec ) );
+    if( err != EEEPROM_ERR_OK ) return err;
+    if( rec.key != RTC_CAL_RECORD_KEY ||
+        rec.check != (uint16_t)~(uint16_t)rec.correction )
+        return RTC_CAL_ERR_NO_RECORD;
+
+    setFreqCorrRTC( rec.correction );
+    return EEEPROM_ERR_OK;
+}
+
+void RTCCalibration::IrqHandler()
+{
+    uint64_t now = stepsRTC();
+
+    if( _edges == 0 ) _firstEdge = now;
+    if( _edges <= _pulses ) {
+        _lastEdge = now;
+        _edges++;
+    }
+}
+
+void RTCCalibration::finish( uint64_t measured, uint64_t expected )
+{
+    int64_t total, diff;
+
+    _correction = rtcFreqCorrection( getFreqCorrRTC(), measured, expected );
+
+    // Bring both under 2^52 and saturate at ~1000 ppm like the correction,
+    // diff * 1000000 then stays under 2^62. The ppm and the remaining ppb are
+    // taken separately so the last multiply can't overflow either.
+    while( expected >= RTC_FREQCORR_SCALE_MAX ) {
+        expected >>= 1;
+        measured >>= 1;
+    }
+    total = (int64_t)expected;
+    diff = (int64_t)measured - total;
+    if( diff > ( total >> 10 ) ) diff = total >> 10;
+    if( diff < -( total >> 10 ) ) diff = -( total >> 10 );
+    diff *= 1000000;
+    _errorPPB = ( int32_t )( ( diff / total ) * 1000 +
+                             ( diff % total ) * 1000 / total );
+    _measured = true;
+}
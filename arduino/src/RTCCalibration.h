@@ -0,0 +1,66 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RTCCALIBRATION_H_
+#define RTCCALIBRATION_H_
+
+#include <stdint.h>
+#include "EEPROM.h"
+
+// Identifies a saved correction in emulated EEPROM, see save()
+#define RTC_CAL_RECORD_KEY 0xCA1B
+#define RTC_CAL_ERR_NO_RECORD -10
+
+// Measures the rate error of the 32 kHz clock driving the RTC (GCLK1) against
+// a reference, either a 1 PPS signal on an EIC pin or the CPU clock, and
+// corrects it with the RTC FREQCORR register. Measuring with a correction
+// already programmed refines it, so a second pass can confirm the first.
+class RTCCalibration
+{
+  public:
+    RTCCalibration();
+    int8_t measurePPS( uint32_t pin, uint16_t pulses, uint32_t timeoutMs );
+    int8_t measureCPUClock( uint16_t seconds, uint32_t refHz = 0 );
+    int8_t apply();
+    int    save( EEEPROM &eeprom, int addr );
+    int    load( EEEPROM &eeprom, int addr );
+    void   IrqHandler();
+
+    // Measured error in parts per billion, positive when the RTC runs fast
+    int32_t getErrorPPB()
+    {
+        return _errorPPB;
+    }
+
+    // FREQCORR value that cancels the measured error, see setFreqCorrRTC()
+    int16_t getCorrection()
+    {
+        return _correction;
+    }
+
+  private:
+    volatile uint64_t _firstEdge, _lastEdge;
+    volatile uint16_t _edges;
+    uint16_t          _pulses;
+    int32_t           _errorPPB;
+    int16_t           _correction;
+    bool              _measured;
+    void              finish( uint64_t measured, uint64_t expected );
+};
+
+#endif /* RTCCALIBRATION_H_ */
@@ -0,0 +1,54 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "RTC.h"
+
+// The correction that cancels a measured rate error. measured and expected
+// are the RTC steps counted and the steps an exact 32768 Hz clock would have
+// counted over the same reference interval (any common scale factor is fine),
+// taken while current was programmed. The result is not clamped. Kept out of
+// RTC.c, with no register access, so tests/host can build it.
+int16_t rtcFreqCorrection( int16_t current, uint64_t measured,
+                           uint64_t expected )
+{
+    int64_t diff, units, limit, total;
+
+    if( expected == 0 ) return current;
+
+    // Only the ratio matters, bring both under 2^52 first. Errors past
+    // ~1000 ppm can't be corrected anyway, with both limits the scaling below
+    // stays under 2^62.
+    while( expected >= RTC_FREQCORR_SCALE_MAX ) {
+        expected >>= 1;
+        measured >>= 1;
+    }
+    total = (int64_t)expected;
+    limit = total >> 10;
+    diff = (int64_t)measured - total;
+    if( diff > limit ) diff = limit;
+    if( diff < -limit ) diff = -limit;
+
+    // Round to the nearest unit
+    units = diff * ( 1 << 20 );
+    if( units < 0 )
+        units = -( ( -units + ( total >> 1 ) ) / total );
+    else
+        units = ( units + ( total >> 1 ) ) / total;
+
+    return ( int16_t )( current - units );
+}
@@ -87,12 +87,18 @@ void SERCOM::initUART( SercomUartMode mode, uint32_t baudrate )
     // Enable the receive data interrupt
     sercom->USART.INTENSET.reg = SERCOM_USART_INTENSET_RXC;
 
-    if( mode == UART_INT_CLOCK ) {
-        uint64_t ratio = 1048576;
-        ratio *= baudrate;
-        ratio /= SystemCoreClock;
-        sercom->USART.BAUD.reg = ( uint16_t )( 65536 - ratio );
-    }
+    if( mode == UART_INT_CLOCK )
+        sercom->USART.BAUD.reg = calculateBaudrateAsynchronous( baudrate );
+}
+
+// Recomputes BAUD from SystemCoreClock for the internally clocked mode, e.g.
+// after a CPU clock change. Anything still being shifted out is cut short.
+void SERCOM::setBaudrateUART( uint32_t baudrate )
+{
+    // Register enable-protected
+    disableUART();
+    sercom->USART.BAUD.reg = calculateBaudrateAsynchronous( baudrate );
+    enableUART();
 }
 
 void SERCOM::initFrame( SercomUartCharSize charSize, SercomDataOrder dataOrder,
@@ -152,6 +158,14 @@ void SERCOM::enableUART()
     } )
 }
 
+void SERCOM::disableUART()
+{
+    ATOMIC_OPERATION( {
+        if( UART_SYNC_BUSY ) UART_WAIT_SYNC;
+        sercom->USART.CTRLA.bit.ENABLE = 0x0u;
+    } )
+}
+
 void SERCOM::flushUART()
 {
     // Skip checking transmission completion if data register is empty
@@ -243,6 +257,22 @@ void SERCOM::disableDataRegisterEmptyInterruptUART()
     sercom->USART.INTENCLR.reg = SERCOM_USART_INTENCLR_DRE;
 }
 
+bool SERCOM::isTransmitCompleteUART()
+{
+    // TXC : Transmit Complete, cleared by writing new data
+    return sercom->USART.INTFLAG.bit.TXC;
+}
+
+void SERCOM::enableTransmitCompleteInterruptUART()
+{
+    sercom->USART.INTENSET.reg = SERCOM_USART_INTENSET_TXC;
+}
+
+void SERCOM::disableTransmitCompleteInterruptUART()
+{
+    sercom->USART.INTENCLR.reg = SERCOM_USART_INTENCLR_TXC;
+}
+
 /*	=========================
  *	===== Sercom SPI
  *	=========================
@@ -452,6 +482,15 @@ uint8_t SERCOM::calculateBaudrateSynchronous( uint32_t baudrate )
     return SystemCoreClock / ( 2 * baudrate ) - 1;
 }
 
+// 16x oversampled arithmetic mode, BAUD = 65536 * (1 - 16 * baud / fref)
+uint16_t SERCOM::calculateBaudrateAsynchronous( uint32_t baudrate )
+{
+    uint64_t ratio = 1048576;
+    ratio *= baudrate;
+    ratio /= SystemCoreClock;
+    return ( uint16_t )( 65536 - ratio );
+}
+
 /*	=========================
  *	===== Sercom WIRE
  *	=========================
@@ -516,18 +555,37 @@ void SERCOM::initMasterWIRE( bool fastMode )
     // Enable smart mode
     sercom->I2CM.CTRLB.reg = SERCOM_I2CM_CTRLB_SMEN;
 
+    // Set the baud rate
+    sercom->I2CM.BAUD.bit.BAUD = calculateBaudrateWIRE( fastMode );
+
+    enableWIRE();
+}
+
+// Recomputes BAUD from SystemCoreClock, e.g. after a CPU clock change. The bus
+// is forced back to idle so this must not be called during a transaction.
+void SERCOM::setBaudrateWIRE( bool fastMode )
+{
+    // Register enable-protected
+    disableWIRE();
+    sercom->I2CM.BAUD.bit.BAUD = calculateBaudrateWIRE( fastMode );
+    enableWIRE();
+}
+
+uint8_t SERCOM::calculateBaudrateWIRE( bool fastMode )
+{
     // Baud rate constants
     const float i2c_fast = 0.00000125;
     const float i2c_slow = 0.000005;
     const float trise_2 = 0.000000125;
 
-    // Set the baud rate
-    uint8_t baud =
-        ( uint8_t )( SystemCoreClock * ( fastMode ? i2c_fast : i2c_slow ) -
-                     SystemCoreClock * trise_2 - 4 );
-    sercom->I2CM.BAUD.bit.BAUD = baud;
+    float baud = SystemCoreClock * ( fastMode ? i2c_fast : i2c_slow ) -
+                 SystemCoreClock * trise_2 - 4;
 
-    enableWIRE();
+    // A clock too slow for the bus rate runs the bus as fast as it can, a
+    // negative value must not be converted to an unsigned type
+    if( baud < 0 ) return 0;
+    if( baud > 0xFF ) return 0xFF;
+    return (uint8_t)baud;
 }
 
 int SERCOM::startTransmissionWIRE( uint8_t addr, bool isWrite )
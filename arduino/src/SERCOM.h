@@ -161,6 +161,8 @@ class SERCOM
     void    resetUART( void );
     void    endUART( void );
     void    enableUART( void );
+    void    disableUART( void );
+    void    setBaudrateUART( uint32_t baudrate );
     void    flushUART( void );
     void    clearStatusUART( void );
     bool    availableDataUART( void );
@@ -175,6 +177,9 @@ class SERCOM
     void    acknowledgeUARTError();
     void    enableDataRegisterEmptyInterruptUART();
     void    disableDataRegisterEmptyInterruptUART();
+    bool    isTransmitCompleteUART();
+    void    enableTransmitCompleteInterruptUART();
+    void    disableTransmitCompleteInterruptUART();
 
     /* ========== SPI ========== */
     void initSPI( SercomSpiTXPad mosi, SercomRXPad miso,
@@ -204,6 +209,7 @@ class SERCOM
     void disableWIRE( void );
     void endWire( void );
     void initMasterWIRE( bool fastMode );
+    void setBaudrateWIRE( bool fastMode );
     int  startTransmissionWIRE( uint8_t addr, bool isWrite );
     int  parseMasterWireStatus();
     int  waitForMBWire();
@@ -219,6 +225,8 @@ class SERCOM
     Sercom *   sercom;
     SercomMode _mode;
     uint8_t    calculateBaudrateSynchronous( uint32_t baudrate );
+    uint16_t   calculateBaudrateAsynchronous( uint32_t baudrate );
+    uint8_t    calculateBaudrateWIRE( bool fastMode );
     uint32_t   division( uint32_t dividend, uint32_t divisor );
     void       enableSERCOM();
     void       disableSERCOM();
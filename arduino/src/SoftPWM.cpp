@@ -0,0 +1,240 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "SoftPWM.h"
+#include "atomic.h"
+
+// Count of the first match after the timer starts
+#define SOFTPWM_FIRST_MATCH 0x100
+
+// Only one engine can own the timer callback at a time
+static SoftPWM *_activeSoftPWM = NULL;
+
+static void softPWMTimerISR()
+{
+    if( _activeSoftPWM != NULL ) _activeSoftPWM->IrqHandler();
+}
+
+SoftPWM::SoftPWM( TimerCounter *timer )
+{
+    _timer = timer;
+    _port = NULL;
+    _channels = 0;
+    _resolution = 0xFFFF;
+    _frequency = 0;
+    _periodTicks = 0;
+    _periodStart = 0;
+    _edge = 0;
+    _isActive = false;
+    _activeSchedule = 0;
+    _swapPending = 0;
+    memset( _schedules, 0, sizeof( _schedules ) );
+}
+
+// Starts the engine at frequency, duty cycles are given in steps of
+// 1 / resolution of the period. Channels must be attached first.
+int8_t SoftPWM::begin( uint32_t frequency, uint16_t resolution )
+{
+    TCPlan_t plan;
+
+    if( _timer == NULL || _port == NULL || resolution == 0 ) return -1;
+    if( _activeSoftPWM != NULL && _activeSoftPWM != this ) return -1;
+
+    // The period is measured with 16 bit wrapping arithmetic on the free
+    // running count, so it must leave at least half the count range for the
+    // interrupt to run late. Planning against twice the clock limits the
+    // period to 0x8000 counts, choosing a coarser prescaler if needed.
+    if( TimerCounter::planFrequency( frequency, &plan, tc_plan_lowest_error,
+                                     tc_mode_16_bit,
+                                     SystemCoreClock * 2 ) != 0 )
+        return -1;
+
+    end();
+
+    _periodTicks = ( plan.cc + 2 ) / 2;
+    _resolution = resolution;
+    for( uint8_t ch = 0; ch < _channels; ch++ )
+        if( _duty[ch] > _resolution ) _duty[ch] = _resolution;
+    commit();
+
+    // The count starts from zero, the first match starts the first period
+    _periodStart = SOFTPWM_FIRST_MATCH - _periodTicks;
+    _edge = _schedules[_activeSchedule].edges;
+    _activeSoftPWM = this;
+    _isActive = true;
+
+    _timer->registerISR( softPWMTimerISR );
+    _timer->beginFreeRunning( tc_mode_16_bit, plan.prescaler, true );
+    _timer->setCompare( 0, SOFTPWM_FIRST_MATCH );
+    if( !_timer->isActive() ) {
+        _timer->deregisterISR();
+        _activeSoftPWM = NULL;
+        _isActive = false;
+        return -1;
+    }
+
+    // The period is planned for the core clock, plan again when it changes
+    _frequency = frequency;
+    registerClockNotifier( NULL, clockPostChange, this );
+
+    return 0;
+}
+
+// Restarts the engine at the same frequency for the new core clock. The
+// channels are off from the restart until the first period begins.
+void SoftPWM::clockPostChange( void *ctx )
+{
+    SoftPWM *pwm = (SoftPWM *)ctx;
+
+    if( pwm->_isActive ) pwm->begin( pwm->_frequency, pwm->_resolution );
+}
+
+// Adds the pin as a channel, returns the channel number or -1
+int8_t SoftPWM::attach( uint32_t pin, uint16_t duty )
+{
+    if( pin >= PINS_COUNT || _channels >= SOFTPWM_MAX_CHANNELS ) return -1;
+
+    PortGroup *port = &PORT->Group[gArduinoPins[pin].port];
+    if( _port != NULL && _port != port ) return -1;
+    _port = port;
+
+    pinMode( pin, OUTPUT );
+    _pinMask[_channels] = ( 1UL << gArduinoPins[pin].pin );
+    _duty[_channels] = duty;
+    _channels++;
+    commit();
+
+    return _channels - 1;
+}
+
+// Stages the duty cycle (0 - resolution) of channel, the new duty cycles of
+// all channels take effect together at the next period after commit()
+void SoftPWM::setDuty( uint8_t channel, uint16_t duty, bool commitNow )
+{
+    if( channel >= _channels ) return;
+
+    _duty[channel] = ( duty > _resolution ) ? _resolution : duty;
+    if( commitNow ) commit();
+}
+
+// Builds the schedule for the staged duty cycles in the idle buffer and hands
+// it to the interrupt, which swaps it in at the next period boundary
+void SoftPWM::commit()
+{
+    if( _periodTicks == 0 ) return;
+
+    // Stop a pending swap so the idle buffer can be rewritten
+    ATOMIC_OPERATION( { _swapPending = 0; } )
+
+    SoftPWMSchedule_t *sched = &_schedules[_activeSchedule ^ 1];
+    sched->edges = 0;
+    sched->setMask = 0;
+    sched->offMask = 0;
+
+    for( uint8_t ch = 0; ch < _channels; ch++ ) {
+        uint16_t t = ( (uint32_t)_duty[ch] * _periodTicks ) / _resolution;
+
+        if( t == 0 ) {
+            sched->offMask |= _pinMask[ch];
+            continue;
+        }
+
+        sched->setMask |= _pinMask[ch];
+        if( t >= _periodTicks ) continue;
+
+        // Insert in time order, merging with an edge at the same time
+        uint8_t e = 0;
+        while( e < sched->edges && sched->time[e] < t ) e++;
+        if( e < sched->edges && sched->time[e] == t ) {
+            sched->clrMask[e] |= _pinMask[ch];
+            continue;
+        }
+
+        for( uint8_t i = sched->edges; i > e; i-- ) {
+            sched->time[i] = sched->time[i - 1];
+            sched->clrMask[i] = sched->clrMask[i - 1];
+        }
+        sched->time[e] = t;
+        sched->clrMask[e] = _pinMask[ch];
+        sched->edges++;
+    }
+
+    ATOMIC_OPERATION( {
+        if( _isActive )
+            _swapPending = 1;
+        else
+            _activeSchedule ^= 1;
+    } )
+}
+
+void SoftPWM::end()
+{
+    if( !_isActive ) return;
+
+    unregisterClockNotifier( clockPostChange, this );
+    _timer->end();
+    _timer->deregisterISR();
+    _isActive = false;
+    _activeSoftPWM = NULL;
+
+    // Leave every channel off
+    uint32_t mask = 0;
+    for( uint8_t ch = 0; ch < _channels; ch++ ) mask |= _pinMask[ch];
+    if( _port != NULL ) _port->OUTCLR.reg = mask;
+}
+
+// Called at each compare match, handles every edge that is due (including
+// ones that came due while handling the last) and sets up the next match
+void SoftPWM::IrqHandler()
+{
+    SoftPWMSchedule_t *sched = &_schedules[_activeSchedule];
+    uint16_t           target;
+
+    for( ;; ) {
+        uint16_t elapsed = _timer->getCount() - _periodStart;
+
+        if( _edge < sched->edges ) {
+            target = sched->time[_edge];
+            if( elapsed >= target ) {
+                _port->OUTCLR.reg = sched->clrMask[_edge++];
+                continue;
+            }
+        }
+        else {
+            target = _periodTicks;
+            if( elapsed >= target ) {
+                _periodStart += _periodTicks;
+                if( _swapPending ) {
+                    _activeSchedule ^= 1;
+                    _swapPending = 0;
+                    sched = &_schedules[_activeSchedule];
+                }
+
+                _port->OUTCLR.reg = sched->offMask;
+                _port->OUTSET.reg = sched->setMask;
+                _edge = 0;
+                continue;
+            }
+        }
+
+        // Stop once the match is set before the count reaches it
+        _timer->setCompare( 0, (uint16_t)( _periodStart + target ) );
+        if( (uint16_t)( _timer->getCount() - _periodStart ) < target ) break;
+    }
+}
@@ -0,0 +1,76 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SOFTPWM_H_
+#define SOFTPWM_H_
+
+#include <stdint.h>
+#include "sam.h"
+#include "TimerCounter.h"
+
+#define SOFTPWM_MAX_CHANNELS 16
+
+// Edge schedule for one period, edges are sorted by time and channels whose
+// edges fall at the same time share one entry
+typedef struct
+{
+    uint8_t  edges;
+    uint16_t time[SOFTPWM_MAX_CHANNELS];
+    uint32_t clrMask[SOFTPWM_MAX_CHANNELS];
+    uint32_t setMask; // Channels turned on at the start of the period
+    uint32_t offMask; // Channels held off for the whole period
+} SoftPWMSchedule_t;
+
+// Drives PWM on any GPIO pins from a single timer. The timer only interrupts
+// at the next scheduled edge so the CPU load depends on the number of distinct
+// edges in a period, not on the resolution. All pins must be on the same port.
+class SoftPWM
+{
+  public:
+    SoftPWM( TimerCounter *timer );
+    int8_t begin( uint32_t frequency, uint16_t resolution = 0xFFFF );
+    int8_t attach( uint32_t pin, uint16_t duty = 0 );
+    void   setDuty( uint8_t channel, uint16_t duty, bool commitNow = true );
+    void   commit();
+    void   end();
+    void   IrqHandler();
+    bool   isActive()
+    {
+        return _isActive;
+    }
+
+  private:
+    TimerCounter *    _timer;
+    PortGroup *       _port;
+    uint8_t           _channels;
+    uint32_t          _pinMask[SOFTPWM_MAX_CHANNELS];
+    uint16_t          _duty[SOFTPWM_MAX_CHANNELS];
+    uint16_t          _resolution;
+    uint32_t          _frequency;
+    uint16_t          _periodTicks;
+    uint16_t          _periodStart;
+    uint8_t           _edge;
+    bool              _isActive;
+    SoftPWMSchedule_t _schedules[2];
+    volatile uint8_t  _activeSchedule;
+    volatile uint8_t  _swapPending;
+
+    static void clockPostChange( void *ctx );
+};
+
+#endif /* SOFTPWM_H_ */
@@ -18,12 +18,18 @@
 
 #include "SysTick.h"
 #include "atomic.h"
+#include "core_debug.h"
+#include <string.h>
 
 volatile uint64_t            _sysTickUnderFlows = 0;
 volatile uint8_t             _tickIsInit = 0;
 volatile uint8_t             _useUpdatedCnt = 0;
+volatile uint32_t            _sysTickEpoch = 0;
+volatile uint8_t             _insideGet = 0;
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
 volatile CPUTix_Debug_t      _tixDBG = {0, 0, 0, 0, 0};
 volatile DelayCPUTix_Debug_t _delayTixDBG = {0, 0, 0, 0, 0};
+#endif
 
 void SysTick_IRQHandler()
 {
@@ -33,7 +39,7 @@ void SysTick_IRQHandler()
     // externally available _useUpdatedCnt field and alert the GET_CPU_TICKS
     // macro that an overflow has occurred. When we re-enter GET_CPU_TICKS the
     // updated under flow counter and new register value should be used.
-    if( _tixDBG.insideGet ) _useUpdatedCnt = 1;
+    if( _insideGet ) _useUpdatedCnt = 1;
 }
 
 void initSysTick()
@@ -45,12 +51,20 @@ void initSysTick()
             SysTick_Config( SYS_TICK_UNDERFLOW ); // Max value is 2^24 ticks
             _sysTickUnderFlows = 0;
             _useUpdatedCnt = 0;
-            _tixDBG.insideGet = 0;
+            _insideGet = 0;
+            _sysTickEpoch++;
             _tickIsInit = 1;
         } )
     }
 }
 
+// Counts every restart of the CPU ticks counter, a reading from getCPUTicks()
+// can only be compared against another reading of the same epoch
+uint32_t sysTickEpoch()
+{
+    return _sysTickEpoch;
+}
+
 void disableSysTick()
 {
     if( _tickIsInit ) {
@@ -68,59 +82,64 @@ void disableSysTick()
 // through STANDBY sleep mode use the stepsRTC() functionality.
 uint64_t getCPUTicks()
 {
-    // Set returned to 0
-    _tixDBG.inside = 1;
-    _tixDBG.tixReturned = 0;
+    uint64_t tix;
+    uint8_t  hadToInit = !_tickIsInit;
+
+    CORE_DEBUG_COUNT( _tixDBG.inside = 1; _tixDBG.hadToInit = hadToInit; )
 
     // Check if the system tick module is initialized
-    _tixDBG.hadToInit = !_tickIsInit;
-    if( _tixDBG.hadToInit ) initSysTick();
+    if( hadToInit ) initSysTick();
 
     // Place the soft lock on the process
-    _tixDBG.insideGet = 1;
-    _tixDBG.tixReturned = ( ( _sysTickUnderFlows << 24 ) |
-                            ( SYS_TICK_UNDERFLOW - SysTick->VAL ) );
+    _insideGet = 1;
+    tix = ( ( _sysTickUnderFlows << 24 ) |
+            ( SYS_TICK_UNDERFLOW - SysTick->VAL ) );
 
     // Check if we need to use the updated count
-    _tixDBG.usedUpdatedCount = _useUpdatedCnt;
-    if( _tixDBG.usedUpdatedCount ) {
-        _tixDBG.tixReturned = ( ( _sysTickUnderFlows << 24 ) |
-                                ( SYS_TICK_UNDERFLOW - SysTick->VAL ) );
+    CORE_DEBUG_COUNT( _tixDBG.usedUpdatedCount = _useUpdatedCnt; )
+    if( _useUpdatedCnt ) {
+        tix = ( ( _sysTickUnderFlows << 24 ) |
+                ( SYS_TICK_UNDERFLOW - SysTick->VAL ) );
         _useUpdatedCnt = 0;
     }
 
     // Remove the soft lock
-    _tixDBG.insideGet = 0;
-    _tixDBG.inside = 0;
+    _insideGet = 0;
 
-    return _tixDBG.tixReturned;
+    CORE_DEBUG_TRACE( _tixDBG.tixReturned = tix; )
+    CORE_DEBUG_COUNT( _tixDBG.inside = 0; )
+    return tix;
 }
 
 void delayCPUTicks( uint64_t tix )
 {
-    // Set the duration
-    _delayTixDBG.inside = 1;
-    _delayTixDBG.tix = tix;
+    uint64_t start, cnt;
+    uint8_t  hadToInit = !_tickIsInit;
+
+    CORE_DEBUG_COUNT( _delayTixDBG.inside = 1;
+                      _delayTixDBG.hadToInit = hadToInit; )
+    CORE_DEBUG_TRACE( _delayTixDBG.tix = tix; )
 
     // Check if the system tick module is initialized
-    _delayTixDBG.hadToInit = !_tickIsInit;
-    if( _delayTixDBG.hadToInit ) initSysTick();
+    if( hadToInit ) initSysTick();
 
     // Get the start time and burn until we reached tix
-    _delayTixDBG.start = getCPUTicks();
+    start = getCPUTicks();
+    CORE_DEBUG_TRACE( _delayTixDBG.start = start; )
     do {
-        _delayTixDBG.cnt = getCPUTicks();
-    } while( ( _delayTixDBG.cnt - _delayTixDBG.start ) < _delayTixDBG.tix );
+        cnt = getCPUTicks();
+        CORE_DEBUG_TRACE( _delayTixDBG.cnt = cnt; )
+    } while( ( cnt - start ) < tix );
 
-    _delayTixDBG.inside = 0;
+    CORE_DEBUG_COUNT( _delayTixDBG.inside = 0; )
 }
 
 void getCPUTixDebugInfo( CPUTix_Debug_t *tix, DelayCPUTix_Debug_t *dTix,
                          uint8_t *init )
 {
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
     tix->hadToInit = _tixDBG.hadToInit;
     tix->inside = _tixDBG.inside;
-    tix->insideGet = _tixDBG.insideGet;
     tix->tixReturned = _tixDBG.tixReturned;
     tix->usedUpdatedCount = _tixDBG.usedUpdatedCount;
 
@@ -129,6 +148,12 @@ void getCPUTixDebugInfo( CPUTix_Debug_t *tix, DelayCPUTix_Debug_t *dTix,
     dTix->inside = _delayTixDBG.inside;
     dTix->start = _delayTixDBG.start;
     dTix->tix = _delayTixDBG.tix;
+#else
+    memset( tix, 0, sizeof( CPUTix_Debug_t ) );
+    memset( dTix, 0, sizeof( DelayCPUTix_Debug_t ) );
+#endif
 
+    // The soft lock and init state are live state, not bookkeeping
+    tix->insideGet = _insideGet;
     *init = _tickIsInit;
 }
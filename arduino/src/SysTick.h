@@ -43,6 +43,7 @@ typedef struct
 
 void     initSysTick();
 void     disableSysTick();
+uint32_t sysTickEpoch();
 uint64_t getCPUTicks();
 void     delayCPUTicks( uint64_t tix );
 void     getCPUTixDebugInfo( CPUTix_Debug_t *tix, DelayCPUTix_Debug_t *dTix,
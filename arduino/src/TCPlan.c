@@ -0,0 +1,126 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "TCPlan.h"
+
+// The timer planner, kept out of TimerCounter.cpp with no register access so
+// tests/host can build it.
+
+const uint8_t tcPrescaleShifts[TC_PRESCALERS] = {0, 1, 2, 3, 4, 6, 8, 10};
+
+// True if a is a better plan than b under policy
+static bool betterPlan( const TCPlan_t *a, const TCPlan_t *b,
+                        TCPlanPolicy_t policy, uint32_t sourceHz,
+                        uint32_t gclkDiv )
+{
+    uint32_t errA = ( a->errorPpm < 0 ) ? -a->errorPpm : a->errorPpm;
+    uint32_t errB = ( b->errorPpm < 0 ) ? -b->errorPpm : b->errorPpm;
+
+    if( policy == tc_plan_lowest_power ) {
+        bool inA = ( errA <= TC_PLAN_MAX_POWER_ERROR_PPM );
+        bool inB = ( errB <= TC_PLAN_MAX_POWER_ERROR_PPM );
+
+        if( inA && inB ) {
+            // Counter clock, a 32 bit counter clocks both timers of the pair
+            uint32_t clk = sourceHz / gclkDiv;
+            uint32_t clkA = clk >> tcPrescaleShifts[a->prescaler];
+            uint32_t clkB = clk >> tcPrescaleShifts[b->prescaler];
+            if( a->mode == tc_mode_32_bit ) clkA *= 2;
+            if( b->mode == tc_mode_32_bit ) clkB *= 2;
+            if( clkA != clkB ) return clkA < clkB;
+        }
+        else if( inA != inB )
+            return inA;
+    }
+
+    // Lowest error, then the narrowest counter, then the finest resolution
+    if( errA != errB ) return errA < errB;
+    if( a->mode != b->mode ) return a->mode < b->mode;
+    return a->prescaler < b->prescaler;
+}
+
+// Searches every prescaler and counter width up to maxMode for the match rate
+// closest to rateHz. The counter clock is sourceHz / gclkDiv. The lowest power
+// policy takes the slowest counter clock within TC_PLAN_MAX_POWER_ERROR_PPM,
+// falling back to the lowest error.
+int8_t tcPlanFrequency( uint32_t rateHz, TCPlan_t *plan, TCPlanPolicy_t policy,
+                        TCMode_t maxMode, uint32_t sourceHz, uint32_t gclkDiv )
+{
+    TCPlan_t candidate;
+    bool     found = false;
+
+    if( plan == NULL ) return -1;
+
+    for( uint8_t mode = tc_mode_8_bit; mode <= maxMode; mode++ ) {
+        if( tcPlanMode( rateHz, (TCMode_t)mode, policy, sourceHz, gclkDiv,
+                        &candidate ) != 0 )
+            continue;
+        if( !found ||
+            betterPlan( &candidate, plan, policy, sourceHz, gclkDiv ) )
+            *plan = candidate;
+        found = true;
+    }
+
+    return found ? 0 : -1;
+}
+
+// Best plan for a single counter width
+int8_t tcPlanMode( uint32_t rateHz, TCMode_t mode, TCPlanPolicy_t policy,
+                   uint32_t sourceHz, uint32_t gclkDiv, TCPlan_t *plan )
+{
+    uint64_t maxCount;
+    bool     found = false;
+
+    if( rateHz == 0 || gclkDiv == 0 ) return -1;
+
+    switch( mode ) {
+        case tc_mode_8_bit: maxCount = (uint64_t)CC_8_BIT_MAX + 1; break;
+        case tc_mode_16_bit: maxCount = (uint64_t)CC_16_BIT_MAX + 1; break;
+        case tc_mode_32_bit: maxCount = (uint64_t)CC_32_BIT_MAX + 1; break;
+        default: return -1;
+    }
+
+    for( uint8_t pre = 0; pre < TC_PRESCALERS; pre++ ) {
+        // Counts per match, rounded to the nearest count
+        uint64_t div = (uint64_t)gclkDiv << tcPrescaleShifts[pre];
+        uint64_t denom = (uint64_t)rateHz * div;
+        uint64_t count = ( (uint64_t)sourceHz + denom / 2 ) / denom;
+        if( count == 0 ) count = 1;
+        if( count > maxCount ) continue;
+
+        TCPlan_t candidate;
+        uint64_t actual = div * count;
+        int64_t  diff = (int64_t)sourceHz - (int64_t)( actual * rateHz );
+
+        candidate.mode = mode;
+        candidate.prescaler = pre;
+        candidate.cc = (uint32_t)( count - 1 );
+        candidate.achievedHz = ( sourceHz + actual / 2 ) / actual;
+        candidate.errorPpm =
+            ( diff * 1000000 ) / (int64_t)( actual * rateHz );
+
+        if( !found ||
+            betterPlan( &candidate, plan, policy, sourceHz, gclkDiv ) )
+            *plan = candidate;
+        found = true;
+    }
+
+    return found ? 0 : -1;
+}
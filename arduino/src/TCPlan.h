@@ -0,0 +1,76 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TCPLAN_H_
+#define TCPLAN_H_
+
+#include <stdint.h>
+
+#define CC_8_BIT_MAX 0xFF
+#define CC_16_BIT_MAX 0xFFFF
+#define CC_32_BIT_MAX 0xFFFFFFFF
+
+// Number of TC_CTRLA_PRESCALER_DIVx_Val settings
+#define TC_PRESCALERS 8
+
+typedef enum
+{
+    tc_mode_8_bit,
+    tc_mode_16_bit,
+    tc_mode_32_bit
+} TCMode_t;
+
+typedef enum
+{
+    tc_plan_lowest_error,
+    tc_plan_lowest_power
+} TCPlanPolicy_t;
+
+// Timer configuration for a match rate, see TimerCounter::planFrequency()
+typedef struct
+{
+    TCMode_t mode;
+    uint32_t prescaler;  // TC_CTRLA_PRESCALER_DIVx_Val
+    uint32_t cc;         // Top of the count, CC0
+    uint32_t achievedHz; // Achieved match rate, rounded
+    int32_t  errorPpm;   // Error of the achieved match rate
+} TCPlan_t;
+
+// Largest error the lowest power policy accepts before falling back to the
+// lowest error
+#ifndef TC_PLAN_MAX_POWER_ERROR_PPM
+#define TC_PLAN_MAX_POWER_ERROR_PPM 1000
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Divider of each TC_CTRLA_PRESCALER_DIVx_Val as a shift
+extern const uint8_t tcPrescaleShifts[TC_PRESCALERS];
+
+int8_t tcPlanFrequency( uint32_t rateHz, TCPlan_t *plan, TCPlanPolicy_t policy,
+                        TCMode_t maxMode, uint32_t sourceHz, uint32_t gclkDiv );
+int8_t tcPlanMode( uint32_t rateHz, TCMode_t mode, TCPlanPolicy_t policy,
+                   uint32_t sourceHz, uint32_t gclkDiv, TCPlan_t *plan );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCPLAN_H_ */
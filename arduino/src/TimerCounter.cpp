@@ -21,10 +21,8 @@
 #include "GPIO.h"
 #include "clocks.h"
 #include "WVariant.h"
-
-#define CC_8_BIT_MAX 0xFF
-#define CC_16_BIT_MAX 0xFFFF
-#define CC_32_BIT_MAX 0xFFFFFFFF
+#include "EventSystem.h"
+#include "atomic.h"
 
 #define TIMER_NVIC_PRIORITY ( ( 1 << __NVIC_PRIO_BITS ) - 1 )
 
@@ -67,6 +65,15 @@ TimerCounter::TimerCounter( Tc *timerCounter )
     _mode = tc_mode_16_bit;
     _ccVal = 0;
     _ctrlA = 0;
+    _prescaleShift = 0;
+    _pwmTop = 0;
+    _matchHz = 0;
+    _dualPWMHz = 0;
+    _wo1Active = false;
+    _sleepHeld = false;
+    _ccPending[0] = 0;
+    _ccPending[1] = 0;
+    _ccPendingMask = 0;
     _isPaused = false;
     _isActive = false;
 }
@@ -83,7 +90,21 @@ void TimerCounter::deregisterISR()
 
 void TimerCounter::beginPWM( uint32_t frequency, uint8_t dutyCycle )
 {
-    begin( frequency / 2, false, tc_mode_16_bit, false );
+    TCPlan_t plan;
+
+    // The PWM period is one full count to CC0
+    if( tcPlanMode( frequency, tc_mode_16_bit, tc_plan_lowest_error,
+                    SystemCoreClock, 1, &plan ) != 0 )
+        return;
+    beginPWM( plan, dutyCycle );
+}
+
+// PWM from a plan for the PWM frequency, the plan must be 16 bit
+void TimerCounter::beginPWM( const TCPlan_t &plan, uint8_t dutyCycle )
+{
+    if( plan.mode != tc_mode_16_bit ) return;
+
+    begin( plan, false, false );
     pause();
 
     // Set wave generation
@@ -92,26 +113,147 @@ void TimerCounter::beginPWM( uint32_t frequency, uint8_t dutyCycle )
 
     // Duty cycle
     setPWMDutyCycle( dutyCycle );
+    setOutputPin( 1 );
+
+    resume();
+}
+
+// Normal PWM on both outputs, WO[0] and WO[1], with independent duty cycles.
+// Up to 8 bits of resolution the 8 bit counter period is set to exactly
+// 2^resolutionBits counts, above that the 16 bit counter always runs to its
+// max so the resolution is 16 bits. The frequency is then the closest the
+// prescaler allows, returns the achieved frequency or 0 on failure.
+uint32_t TimerCounter::beginDualPWM( uint32_t frequency,
+                                     uint8_t  resolutionBits )
+{
+    TCMode_t mode = ( resolutionBits > 8 ) ? tc_mode_16_bit : tc_mode_8_bit;
+    uint32_t top = ( resolutionBits > 8 ) ? CC_16_BIT_MAX
+                                          : ( 1UL << resolutionBits ) - 1;
+    uint32_t bestPre, bestFreq;
+
+    if( frequency == 0 || resolutionBits < 2 || resolutionBits > 16 ) return 0;
+
+    bestPre = dualPWMPrescaler( frequency, top, &bestFreq );
+    if( beginCounter( mode, bestPre ) != 0 ) return 0;
+    _pwmTop = top;
+    _ccPendingMask = 0;
+
+    // The control registers share the same layout in every mode
+    _ctrlA |= TC_CTRLA_WAVEGEN_NPWM;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    if( mode == tc_mode_8_bit ) {
+        _timerCounter->COUNT8.PER.reg = top;
+        waitRegSync();
+        _timerCounter->COUNT8.CC[0].reg = 0;
+        waitRegSync();
+        _timerCounter->COUNT8.CC[1].reg = 0;
+    }
+    else {
+        _timerCounter->COUNT16.CC[0].reg = 0;
+        waitRegSync();
+        _timerCounter->COUNT16.CC[1].reg = 0;
+    }
+    waitRegSync();
+
+    // Pending duty cycles are written from the overflow interrupt
+    _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_MASK;
+    NVIC_EnableIRQ( (IRQn_Type)_irqn );
+
+    _ctrlA |= TC_CTRLA_ENABLE;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    waitRegSync();
+
+    setOutputPin( 0 );
+    setOutputPin( 1 );
+    _isActive = true;
+
+    // The prescaler is chosen for the core clock, choose again when it changes
+    _dualPWMHz = frequency;
+    registerClockNotifier( NULL, clockPostChange, this );
+
+    return bestFreq;
+}
+
+// The prescaler giving the period of top + 1 counts closest to frequency
+uint8_t TimerCounter::dualPWMPrescaler( uint32_t frequency, uint32_t top,
+                                        uint32_t *achieved )
+{
+    uint32_t bestPre = 0, bestErr = 0xFFFFFFFF;
+
+    for( uint8_t pre = 0; pre <= TC_CTRLA_PRESCALER_DIV1024_Val; pre++ ) {
+        uint32_t freq =
+            ( SystemCoreClock >> tcPrescaleShifts[pre] ) / ( top + 1 );
+        uint32_t err = ( freq > frequency ) ? freq - frequency
+                                            : frequency - freq;
+        if( err < bestErr ) {
+            bestErr = err;
+            bestPre = pre;
+            *achieved = freq;
+        }
+    }
+
+    return bestPre;
+}
+
+// Sets the duty cycle of output channel as a 16 bit fraction of the period.
+// The compare value is written at the next overflow so a period is never cut
+// short, a compare value the counter has already passed when the interrupt
+// runs holds the output high for that one period.
+void TimerCounter::setPWMDuty( uint8_t channel, uint16_t duty )
+{
+    if( channel > 1 || _pwmTop == 0 ) return;
+
+    uint32_t cc = ( (uint32_t)duty * ( _pwmTop + 1 ) ) >> 16;
+
+    ATOMIC_OPERATION( {
+        _ccPending[channel] = cc;
+        _ccPendingMask |= ( 1 << channel );
+    } )
+    _timerCounter->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+}
+
+// Drives the waveform output channel, WO[0] or WO[1], onto its pin
+void TimerCounter::setOutputPin( uint8_t channel )
+{
+    uint8_t pin;
 
     switch( _tcNum ) {
-        case 2: pinMode( 6, gArduinoPins[6].timer ); break;
-        case 3: pinMode( 4, gArduinoPins[4].timer ); break;
-        case 4: pinMode( 10, gArduinoPins[10].timer ); break;
-        case 5: pinMode( 0, gArduinoPins[0].timer ); break;
+        case 2: pin = ( channel ) ? TC2_OUTPIN1 : TC2_OUTPIN; break;
+        case 3: pin = ( channel ) ? TC3_OUTPIN1 : TC3_OUTPIN; break;
+        case 4: pin = ( channel ) ? TC4_OUTPIN1 : TC4_OUTPIN; break;
+        case 5: pin = ( channel ) ? TC5_OUTPIN1 : TC5_OUTPIN; break;
+        default: return;
     }
 
-    resume();
+    pinMode( pin, gArduinoPins[pin].timer );
+    if( channel ) _wo1Active = true;
 }
 
+// The output toggles on every match so the match rate is twice frequency
 void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
-                          bool useInterrupts )
+                          bool useInterrupts, TCEventOutput_t event )
 {
-    _maxFreq = SystemCoreClock / 2;
-    _mode = mode;
+    TCPlan_t plan;
+
+    if( tcPlanMode( frequency * 2, mode, tc_plan_lowest_error,
+                    SystemCoreClock, 1, &plan ) != 0 )
+        return;
+    begin( plan, output, useInterrupts, event );
+}
+
+// Starts the timer from a plan made by planFrequency() for the main clock
+// (GCLK0), the match rate is plan.achievedHz
+void TimerCounter::begin( const TCPlan_t &plan, bool output,
+                          bool useInterrupts, TCEventOutput_t event )
+{
+    uint16_t evCtrl = 0;
+    _mode = plan.mode;
 
     if( _clkID == 0 ) return;
+    if( _mode == tc_mode_32_bit && ( _tcNum % 2 ) != 0 ) return;
     enableAPBCClk( _APBCMask, 1 );
     initGenericClk( GCLK_CLKCTRL_GEN_GCLK0_Val, _clkID );
+    holdSleep( true );
     if( useInterrupts ) NVIC_EnableIRQ( (IRQn_Type)_irqn );
     if( output ) {
         switch( _tcNum ) {
@@ -133,12 +275,20 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
     // SWRST
     reset();
 
-    switch( mode ) {
+    // Event output, routed to other peripherals through the event system
+    switch( event ) {
+        case tc_event_ovf: evCtrl = TC_EVCTRL_OVFEO; break;
+        case tc_event_mc0: evCtrl = TC_EVCTRL_MCEO0; break;
+        case tc_event_mc1: evCtrl = TC_EVCTRL_MCEO1; break;
+        default: break;
+    }
+
+    switch( _mode ) {
         case tc_mode_8_bit:
             _ctrlA = TC_CTRLA_MODE_COUNT8;
 
             // Configure period, and pre-scalers
-            setDividerAndCC( frequency, CC_8_BIT_MAX );
+            setDividerAndCC( plan );
             _timerCounter->COUNT8.CC[0].reg = (uint8_t)_ccVal;
             waitRegSync();
 
@@ -147,6 +297,7 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
 
             // Allow continuous reads
             _timerCounter->COUNT8.READREQ.bit.RCONT = 1;
+            _timerCounter->COUNT8.EVCTRL.reg = evCtrl;
 
             // Enable the module and interrupts
             _ctrlA |= TC_CTRLA_ENABLE;
@@ -158,7 +309,7 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
             _ctrlA = TC_CTRLA_MODE_COUNT16;
 
             // Configure period, and pre-scalers
-            setDividerAndCC( frequency, CC_16_BIT_MAX );
+            setDividerAndCC( plan );
             _timerCounter->COUNT16.CC[0].reg = (uint16_t)_ccVal;
             waitRegSync();
 
@@ -167,6 +318,7 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
 
             // Allow continuous reads
             _timerCounter->COUNT16.READREQ.bit.RCONT = 1;
+            _timerCounter->COUNT16.EVCTRL.reg = evCtrl;
 
             // Enable the module and interrupts
             _ctrlA |= TC_CTRLA_ENABLE;
@@ -175,13 +327,11 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
 
             break;
         case tc_mode_32_bit:
-            if( ( _tcNum % 2 ) != 0 ) return;
-
             _ctrlA = TC_CTRLA_MODE_COUNT32;
 
             // Configure period, and pre-scalers
-            setDividerAndCC( frequency, CC_32_BIT_MAX );
-            _timerCounter->COUNT32.CC[0].reg = (uint8_t)_ccVal;
+            setDividerAndCC( plan );
+            _timerCounter->COUNT32.CC[0].reg = _ccVal;
             waitRegSync();
 
             // Enable compare capture interrupt 0
@@ -189,6 +339,7 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
 
             // Allow continuous reads
             _timerCounter->COUNT32.READREQ.bit.RCONT = 1;
+            _timerCounter->COUNT32.EVCTRL.reg = evCtrl;
 
             // Enable the module and interrupts
             _ctrlA |= TC_CTRLA_ENABLE;
@@ -200,6 +351,124 @@ void TimerCounter::begin( uint32_t frequency, bool output, TCMode_t mode,
     }
 
     _isActive = true;
+
+    // The plan is made for the core clock, plan again when it changes
+    _matchHz = plan.achievedHz;
+    registerClockNotifier( NULL, clockPostChange, this );
+}
+
+// Captures the count on input events instead of generating a waveform. The
+// timer counts the main clock divided by prescaler (TC_CTRLA_PRESCALER_DIVx),
+// invert swaps the active level of the input event.
+void TimerCounter::beginCapture( TCCaptureMode_t capture, TCMode_t mode,
+                                 uint32_t prescaler, bool invert,
+                                 bool useInterrupts )
+{
+    uint16_t evCtrl = TC_EVCTRL_TCEI;
+    uint8_t  ctrlC = TC_CTRLC_CPTEN0;
+    uint8_t  intEn = TC_INTENSET_MC0;
+
+    switch( capture ) {
+        case tc_capture_ppw:
+            evCtrl |= TC_EVCTRL_EVACT_PPW;
+            ctrlC |= TC_CTRLC_CPTEN1;
+            intEn = TC_INTENSET_MC1;
+            break;
+        case tc_capture_pwp:
+            evCtrl |= TC_EVCTRL_EVACT_PWP;
+            ctrlC |= TC_CTRLC_CPTEN1;
+            break;
+        case tc_capture_retrigger: evCtrl |= TC_EVCTRL_EVACT_RETRIGGER; break;
+        default: return;
+    }
+    if( invert ) evCtrl |= TC_EVCTRL_TCINV;
+
+    if( beginCounter( mode, prescaler ) != 0 ) return;
+
+    // The control and event registers share the same layout in every mode
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    _timerCounter->COUNT16.CTRLC.reg = ctrlC;
+    waitRegSync();
+    _timerCounter->COUNT16.EVCTRL.reg = evCtrl;
+    _timerCounter->COUNT16.READREQ.bit.RCONT = 1;
+
+    // The capture interrupt fires once a complete measurement is available
+    _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_MASK;
+    if( useInterrupts ) {
+        _timerCounter->COUNT16.INTENSET.reg = intEn;
+        NVIC_EnableIRQ( (IRQn_Type)_irqn );
+    }
+
+    _ctrlA |= TC_CTRLA_ENABLE;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    waitRegSync();
+
+    _isActive = true;
+}
+
+// Counts up continuously from the main clock divided by prescaler and wraps at
+// the top of the counter, read the count with getCount(). With interrupts the
+// ISR is called each time the count matches CC0, see setCompare().
+void TimerCounter::beginFreeRunning( TCMode_t mode, uint32_t prescaler,
+                                     bool useInterrupts )
+{
+    if( beginCounter( mode, prescaler ) != 0 ) return;
+
+    _ctrlA |= TC_CTRLA_WAVEGEN_NFRQ;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    if( mode == tc_mode_8_bit ) {
+        _timerCounter->COUNT8.PER.reg = CC_8_BIT_MAX;
+        waitRegSync();
+    }
+    _timerCounter->COUNT16.READREQ.bit.RCONT = 1;
+
+    _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_MASK;
+    if( useInterrupts ) {
+        _timerCounter->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+        NVIC_EnableIRQ( (IRQn_Type)_irqn );
+    }
+
+    _ctrlA |= TC_CTRLA_ENABLE;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    waitRegSync();
+
+    _isActive = true;
+}
+
+// Counts input events (see getEventUser) instead of clock cycles, wrapping at
+// the top of the counter. In standby the timer runs from the 32 kHz GCLK1, so
+// events must be at least two of its cycles apart to be counted, and the timer
+// sharing this one's generic clock is moved to GCLK1 as well. With interrupts
+// the ISR is called on each overflow.
+void TimerCounter::beginEventCounter( TCMode_t mode, bool runInStandby,
+                                      bool useInterrupts )
+{
+    uint32_t genClk = GCLK_CLKCTRL_GEN_GCLK0_Val;
+
+    if( runInStandby ) genClk = GCLK_CLKCTRL_GEN_GCLK1_Val;
+    if( beginCounter( mode, TC_CTRLA_PRESCALER_DIV1_Val, genClk ) != 0 ) return;
+
+    if( runInStandby ) _ctrlA |= TC_CTRLA_RUNSTDBY;
+    _ctrlA |= TC_CTRLA_WAVEGEN_NFRQ;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    if( mode == tc_mode_8_bit ) {
+        _timerCounter->COUNT8.PER.reg = CC_8_BIT_MAX;
+        waitRegSync();
+    }
+    _timerCounter->COUNT16.EVCTRL.reg = TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_COUNT;
+    _timerCounter->COUNT16.READREQ.bit.RCONT = 1;
+
+    _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_MASK;
+    if( useInterrupts ) {
+        _timerCounter->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+        NVIC_EnableIRQ( (IRQn_Type)_irqn );
+    }
+
+    _ctrlA |= TC_CTRLA_ENABLE;
+    _timerCounter->COUNT16.CTRLA.reg = _ctrlA;
+    waitRegSync();
+
+    _isActive = true;
 }
 
 void TimerCounter::reset()
@@ -226,11 +495,16 @@ void TimerCounter::reset()
 
     _ctrlA = 0;
     _ccVal = 0;
+    _matchHz = 0;
+    _dualPWMHz = 0;
     _isPaused = false;
 }
 
 void TimerCounter::end()
 {
+    bool slaveClk = _isActive && _mode == tc_mode_32_bit;
+
+    unregisterClockNotifier( clockPostChange, this );
     reset();
     _isActive = false;
 
@@ -241,9 +515,25 @@ void TimerCounter::end()
         case 5: pinMode( 1, TRI_STATE ); break;
     }
 
+    if( _wo1Active ) {
+        switch( _tcNum ) {
+            case 2: pinMode( TC2_OUTPIN1, TRI_STATE ); break;
+            case 3: pinMode( TC3_OUTPIN1, TRI_STATE ); break;
+            case 4: pinMode( TC4_OUTPIN1, TRI_STATE ); break;
+            case 5: pinMode( TC5_OUTPIN1, TRI_STATE ); break;
+        }
+        _wo1Active = false;
+    }
+    _pwmTop = 0;
+    holdSleep( false );
+
     NVIC_DisableIRQ( (IRQn_Type)_irqn );
     disableGenericClk( _clkID );
     enableAPBCClk( _APBCMask, 0 );
+
+    // The slave of a 32 bit pair was clocked by beginCounter(), a timer that
+    // isn't running may no longer own it
+    if( slaveClk ) enableAPBCClk( _APBCMask << 1, 0 );
 }
 
 void TimerCounter::resume()
@@ -290,11 +580,32 @@ void TimerCounter::pause()
 
 void TimerCounter::IrqHandler()
 {
+    // The interrupt registers share the same layout in every mode
+    uint8_t flags = _timerCounter->COUNT16.INTFLAG.reg &
+                    _timerCounter->COUNT16.INTENSET.reg;
+
+    // Apply pending duty cycles at the start of the period
+    if( ( flags & TC_INTFLAG_OVF ) && _pwmTop != 0 ) {
+        for( uint8_t ch = 0; ch < 2; ch++ ) {
+            if( !( _ccPendingMask & ( 1 << ch ) ) ) continue;
+            if( _mode == tc_mode_8_bit )
+                _timerCounter->COUNT8.CC[ch].reg = _ccPending[ch];
+            else
+                _timerCounter->COUNT16.CC[ch].reg = _ccPending[ch];
+        }
+        _ccPendingMask = 0;
+        _timerCounter->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF;
+        _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        if( !( flags & ~TC_INTFLAG_OVF ) ) return;
+    }
+
     switch( _mode ) {
         case tc_mode_8_bit: _timerCounter->COUNT8.INTFLAG.bit.MC0 = 1; break;
         case tc_mode_16_bit: _timerCounter->COUNT16.INTFLAG.bit.MC0 = 1; break;
         case tc_mode_32_bit: _timerCounter->COUNT32.INTFLAG.bit.MC0 = 1; break;
     }
+    if( flags & TC_INTFLAG_OVF )
+        _timerCounter->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
 
     if( isrPtr != NULL ) isrPtr();
 }
@@ -326,6 +637,25 @@ void TimerCounter::setCount( uint32_t count )
     waitRegSync();
 }
 
+void TimerCounter::setCompare( uint8_t channel, uint32_t value )
+{
+    if( channel > 1 ) return;
+
+    switch( _mode ) {
+        case tc_mode_8_bit:
+            _timerCounter->COUNT8.CC[channel].reg = value & CC_8_BIT_MAX;
+            break;
+        case tc_mode_16_bit:
+            _timerCounter->COUNT16.CC[channel].reg = value & CC_16_BIT_MAX;
+            break;
+        case tc_mode_32_bit:
+            _timerCounter->COUNT32.CC[channel].reg = value;
+            break;
+    }
+
+    waitRegSync();
+}
+
 void TimerCounter::setPWMDutyCycle( uint8_t dutyCycle )
 {
     // Set duty cycle
@@ -336,38 +666,186 @@ void TimerCounter::setPWMDutyCycle( uint8_t dutyCycle )
     waitRegSync();
 }
 
-void TimerCounter::setDividerAndCC( uint32_t freq, uint32_t maxCC )
+// Returns the event system generator ID for the requested event output of this
+// timer, the output must also be enabled in begin()
+uint8_t TimerCounter::getEventGenerator( TCEventOutput_t event )
+{
+    if( _tcNum == -1 ) return EVENT_GEN_NONE;
+
+    switch( event ) {
+        case tc_event_ovf: return EVENT_GEN_TC_OVF( _tcNum );
+        case tc_event_mc0: return EVENT_GEN_TC_MC0( _tcNum );
+        case tc_event_mc1: return EVENT_GEN_TC_MC1( _tcNum );
+        default: return EVENT_GEN_NONE;
+    }
+}
+
+// Returns the event system user ID for the input event of this timer
+uint8_t TimerCounter::getEventUser()
 {
-    uint32_t preScaleBits = 0;
+    if( _tcNum == -1 ) return EVENT_USER_NONE;
+    return EVENT_USER_TC( _tcNum );
+}
+
+// True when the counter has wrapped and the overflow has not been handled, the
+// overflow interrupt clears it
+bool TimerCounter::overflowPending()
+{
+    return ( _timerCounter->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF ) != 0;
+}
 
+// True when channel has captured a value since it was last read
+bool TimerCounter::captureReady( uint8_t channel )
+{
+    if( channel > 1 ) return false;
+    return ( _timerCounter->COUNT16.INTFLAG.reg >> ( 4 + channel ) ) & 0x1;
+}
+
+// Reads the captured value of channel, which also clears its ready flag
+uint32_t TimerCounter::getCapture( uint8_t channel )
+{
+    uint32_t val = 0;
+    if( channel > 1 ) return 0;
+
+    switch( _mode ) {
+        case tc_mode_8_bit: val = _timerCounter->COUNT8.CC[channel].reg; break;
+        case tc_mode_16_bit:
+            val = _timerCounter->COUNT16.CC[channel].reg;
+            break;
+        case tc_mode_32_bit:
+            val = _timerCounter->COUNT32.CC[channel].reg;
+            break;
+    }
+
+    _timerCounter->COUNT16.INTFLAG.reg = ( TC_INTFLAG_MC0 << channel );
+    return val;
+}
+
+// Frequency in Hz of the counts in the capture and free running modes
+uint32_t TimerCounter::getCaptureFrequency()
+{
+    return SystemCoreClock >> _prescaleShift;
+}
+
+// Common bring up for the counting modes, leaves the mode and prescaler in
+// _ctrlA for the caller to finish configuring before enabling
+int8_t TimerCounter::beginCounter( TCMode_t mode, uint32_t prescaler,
+                                   uint32_t genClk )
+{
+    if( _clkID == 0 ) return -1;
+    if( prescaler > TC_CTRLA_PRESCALER_DIV1024_Val ) return -1;
+    if( mode == tc_mode_32_bit && ( _tcNum % 2 ) != 0 ) return -1;
+
+    _mode = mode;
+    enableAPBCClk( _APBCMask, 1 );
+
+    // The odd timer of the pair is the slave in 32 bit mode
+    if( mode == tc_mode_32_bit ) enableAPBCClk( _APBCMask << 1, 1 );
+    initGenericClk( genClk, _clkID );
+    holdSleep( genClk == GCLK_CLKCTRL_GEN_GCLK0_Val );
+
+    // SWRST
+    reset();
+
+    switch( mode ) {
+        case tc_mode_8_bit: _ctrlA = TC_CTRLA_MODE_COUNT8; break;
+        case tc_mode_16_bit: _ctrlA = TC_CTRLA_MODE_COUNT16; break;
+        case tc_mode_32_bit: _ctrlA = TC_CTRLA_MODE_COUNT32; break;
+        default: return -1;
+    }
+    _ctrlA |= TC_CTRLA_PRESCALER( prescaler );
+    _prescaleShift = tcPrescaleShifts[prescaler];
+
+    return 0;
+}
+
+// GCLK0 stops in standby, a timer running from it keeps the CPU in idle
+void TimerCounter::holdSleep( bool hold )
+{
+    if( hold == _sleepHeld ) return;
+
+    _sleepHeld = hold;
+    if( hold )
+        holdSleepLevel( _cpu_ahb_apb );
+    else
+        releaseSleepLevel( _cpu_ahb_apb );
+}
+
+void TimerCounter::setDividerAndCC( const TCPlan_t &plan )
+{
     _ctrlA |= TC_CTRLA_WAVEGEN_MFRQ; // Toggle mode
+    _ctrlA |= TC_CTRLA_PRESCALER( plan.prescaler );
+    _prescaleShift = tcPrescaleShifts[plan.prescaler];
+    _ccVal = plan.cc;
+}
 
-    _ccVal = _maxFreq / freq - 1;
-    preScaleBits = TC_CTRLA_PRESCALER_DIV1;
+void TimerCounter::clockPostChange( void *ctx )
+{
+    ( (TimerCounter *)ctx )->retime();
+}
 
-    uint8_t i = 0;
+// Keeps a running waveform at its rate after a CPU clock change. Timers from
+// begin() and beginPWM() are planned again at the same width, CC1 keeping its
+// fraction of the period, and beginDualPWM() timers choose their prescaler
+// again. Capture and free running counts just follow the new clock, see
+// getCaptureFrequency(), a user timing waveforms from a free running count
+// registers its own notifier (see SoftPWM and EdgeCapture).
+void TimerCounter::retime()
+{
+    TCPlan_t plan;
+    uint32_t prescaler, achieved, cc1;
+    bool     paused = _isPaused;
 
-    while( i <= 9 ) {
-        _ccVal = _maxFreq / freq / ( 2 << i ) - 1;
-        if( _ccVal < maxCC ) break;
-        i++;
-        if( i == 4 || i == 6 ||
-            i == 8 ) // DIV32 DIV128 and DIV512 are not available
-            i++;
+    if( !_isActive ) return;
+
+    if( _matchHz != 0 ) {
+        if( tcPlanMode( _matchHz, _mode, tc_plan_lowest_error,
+                        SystemCoreClock, 1, &plan ) != 0 )
+            return;
+        prescaler = plan.prescaler;
     }
+    else if( _dualPWMHz != 0 )
+        prescaler = dualPWMPrescaler( _dualPWMHz, _pwmTop, &achieved );
+    else
+        return;
 
-    switch( i ) {
-        case 0: preScaleBits = TC_CTRLA_PRESCALER_DIV2; break;
-        case 1: preScaleBits = TC_CTRLA_PRESCALER_DIV4; break;
-        case 2: preScaleBits = TC_CTRLA_PRESCALER_DIV8; break;
-        case 3: preScaleBits = TC_CTRLA_PRESCALER_DIV16; break;
-        case 5: preScaleBits = TC_CTRLA_PRESCALER_DIV64; break;
-        case 7: preScaleBits = TC_CTRLA_PRESCALER_DIV256; break;
-        case 9: preScaleBits = TC_CTRLA_PRESCALER_DIV1024; break;
-        default: break;
+    // The prescaler is enable-protected, the control registers share the same
+    // layout in every mode
+    pause();
+    _ctrlA &= ~TC_CTRLA_PRESCALER_Msk;
+    _ctrlA |= TC_CTRLA_PRESCALER( prescaler );
+    _prescaleShift = tcPrescaleShifts[prescaler];
+    _timerCounter->COUNT16.CTRLA.reg =
+        ( _timerCounter->COUNT16.CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk ) |
+        TC_CTRLA_PRESCALER( prescaler );
+    waitRegSync();
+
+    if( _matchHz != 0 ) {
+        switch( _mode ) {
+            case tc_mode_8_bit: cc1 = _timerCounter->COUNT8.CC[1].reg; break;
+            case tc_mode_16_bit: cc1 = _timerCounter->COUNT16.CC[1].reg; break;
+            default: cc1 = _timerCounter->COUNT32.CC[1].reg; break;
+        }
+        cc1 = ( uint32_t )( ( (uint64_t)cc1 * ( plan.cc + 1ull ) ) /
+                            ( _ccVal + 1ull ) );
+        _ccVal = plan.cc;
+        setCompare( 0, _ccVal );
+        setCompare( 1, cc1 );
+        setCount( 0 );
     }
 
-    _ctrlA |= preScaleBits;
+    if( !paused ) resume();
+}
+
+// Searches every prescaler and counter width up to maxMode for the match rate
+// closest to rateHz, see tcPlanFrequency(). A sourceHz of 0 means the main
+// clock.
+int8_t TimerCounter::planFrequency( uint32_t rateHz, TCPlan_t *plan,
+                                    TCPlanPolicy_t policy, TCMode_t maxMode,
+                                    uint32_t sourceHz, uint32_t gclkDiv )
+{
+    if( sourceHz == 0 ) sourceHz = SystemCoreClock;
+    return tcPlanFrequency( rateHz, plan, policy, maxMode, sourceHz, gclkDiv );
 }
 
 void TimerCounter::waitRegSync()
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 #include "sam.h"
+#include "TCPlan.h"
 
 #if defined( __SAMD20E18__ )
 #define TC0_OUTPIN 0 // TODO
@@ -29,14 +30,30 @@
 #define TC3_OUTPIN 3
 #define TC4_OUTPIN 9
 #define TC5_OUTPIN 1
+
+// Second waveform output, WO[1]
+#define TC2_OUTPIN1 6
+#define TC3_OUTPIN1 4
+#define TC4_OUTPIN1 10
+#define TC5_OUTPIN1 0
 #endif /* __SAMD20E18 */
 
 typedef enum
 {
-    tc_mode_8_bit,
-    tc_mode_16_bit,
-    tc_mode_32_bit
-} TCMode_t;
+    tc_event_none,
+    tc_event_ovf,
+    tc_event_mc0,
+    tc_event_mc1
+} TCEventOutput_t;
+
+// Capture of an input event (see EventSystem.h), the event is routed to the
+// user returned by getEventUser()
+typedef enum
+{
+    tc_capture_ppw,      // CC0 = period, CC1 = pulse width
+    tc_capture_pwp,      // CC0 = pulse width, CC1 = period
+    tc_capture_retrigger // CC0 = time between events
+} TCCaptureMode_t;
 
 class TimerCounter
 {
@@ -45,8 +62,24 @@ class TimerCounter
     void     registerISR( void ( *isr )() );
     void     deregisterISR();
     void     beginPWM( uint32_t frequency, uint8_t dutyCycle );
+    void     beginPWM( const TCPlan_t &plan, uint8_t dutyCycle );
     void     begin( uint32_t frequency, bool output = false,
-                    TCMode_t mode = tc_mode_16_bit, bool useInterrupts = false );
+                    TCMode_t mode = tc_mode_16_bit, bool useInterrupts = false,
+                    TCEventOutput_t event = tc_event_none );
+    void     begin( const TCPlan_t &plan, bool output = false,
+                    bool useInterrupts = false,
+                    TCEventOutput_t event = tc_event_none );
+    void     beginCapture( TCCaptureMode_t capture,
+                           TCMode_t        mode = tc_mode_16_bit,
+                           uint32_t prescaler = TC_CTRLA_PRESCALER_DIV1_Val,
+                           bool invert = false, bool useInterrupts = false );
+    void     beginFreeRunning(
+            TCMode_t mode = tc_mode_32_bit,
+            uint32_t prescaler = TC_CTRLA_PRESCALER_DIV1_Val,
+            bool     useInterrupts = false );
+    void     beginEventCounter( TCMode_t mode = tc_mode_16_bit,
+                                bool     runInStandby = true,
+                                bool     useInterrupts = false );
     void     reset();
     void     end();
     void     resume();
@@ -54,6 +87,7 @@ class TimerCounter
     void     IrqHandler();
     uint32_t getCount();
     void     setCount( uint32_t count );
+    void     setCompare( uint8_t channel, uint32_t value );
     bool     isActive()
     {
         return _isActive;
@@ -62,23 +96,54 @@ class TimerCounter
     {
         return _isPaused;
     }
-    void setPWMDutyCycle( uint8_t dutyCycle );
+    void     setPWMDutyCycle( uint8_t dutyCycle );
+    uint32_t beginDualPWM( uint32_t frequency, uint8_t resolutionBits );
+    void     setPWMDuty( uint8_t channel, uint16_t duty );
+    uint8_t  getEventGenerator( TCEventOutput_t event );
+    uint8_t  getEventUser();
+    bool     captureReady( uint8_t channel );
+    uint32_t getCapture( uint8_t channel );
+    bool     overflowPending();
+    uint32_t getCaptureFrequency();
+
+    static int8_t planFrequency( uint32_t rateHz, TCPlan_t *plan,
+                                 TCPlanPolicy_t policy = tc_plan_lowest_error,
+                                 TCMode_t       maxMode = tc_mode_32_bit,
+                                 uint32_t sourceHz = 0, uint32_t gclkDiv = 1 );
 
   private:
     int8_t   _tcNum;
     bool     _isPaused;
     bool     _isActive;
-    uint32_t _maxFreq;
     uint32_t _ccVal;
     uint32_t _ctrlA;
+    uint8_t  _prescaleShift;
+    uint32_t _pwmTop;
+    uint32_t _matchHz;   // Match rate to keep across clock changes, or 0
+    uint32_t _dualPWMHz; // Dual PWM frequency to keep, or 0
+    bool     _wo1Active;
+    bool     _sleepHeld;
     Tc *     _timerCounter;
     TCMode_t _mode;
     uint32_t _APBCMask;
     uint32_t _clkID;
     uint32_t _irqn;
     void ( *isrPtr )();
-    void setDividerAndCC( uint32_t freq, uint32_t maxCC );
-    void waitRegSync();
+
+    // Duty cycles waiting for the next overflow, see setPWMDuty()
+    volatile uint32_t _ccPending[2];
+    volatile uint8_t  _ccPendingMask;
+
+    int8_t beginCounter( TCMode_t mode, uint32_t prescaler,
+                         uint32_t genClk = GCLK_CLKCTRL_GEN_GCLK0_Val );
+    void   setOutputPin( uint8_t channel );
+    void   holdSleep( bool hold );
+    void   setDividerAndCC( const TCPlan_t &plan );
+    void   retime();
+    static void    clockPostChange( void *ctx );
+    static uint8_t dualPWMPrescaler( uint32_t frequency, uint32_t top,
+                                     uint32_t *achieved );
+    void   waitRegSync();
 };
 
 #endif /* TIMERCOUNTER_H_ */
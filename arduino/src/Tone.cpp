@@ -17,62 +17,141 @@
 */
 
 #include "Tone.h"
+#include "RTC.h"
+#include "atomic.h"
+#include "variant.h"
 
-uint64_t _durationCounts;
-uint64_t _counter;
-uint8_t  _channel;
+typedef struct
+{
+    const Note *notes; // 0 for a single tone
+    uint16_t    count;
+    uint16_t    index;
+    bool        repeat;
+    uint64_t    endStep; // RTC step the current note ends on, 0 when idle
+} ToneChannel_t;
+
+static volatile ToneChannel_t _tones[TONE_CHANNELS];
+static TimerCounter *const    _toneTimers[TONE_CHANNELS] = {&Timer, &Timer1,
+                                                         &Timer2, &Timer3};
+
+static void stopTone( uint8_t channel )
+{
+    _tones[channel].notes = 0;
+    _tones[channel].endStep = 0;
+    _toneTimers[channel]->end();
+}
 
-void toneISR()
+// Starts the note at the channel's index, the note's duration is counted from
+// fromStep so a sequence does not drift with the interrupt latency
+static void startNote( uint8_t channel, uint64_t fromStep )
 {
-    if( ++_counter > _durationCounts ) {
-        switch( _channel ) {
-            case 0: Timer.end(); break;
-            case 1: Timer1.end(); break;
-            case 2: Timer2.end(); break;
-            case 3: Timer3.end(); break;
+    volatile ToneChannel_t *t = &_tones[channel];
+    const Note *            n = &t->notes[t->index];
+    uint64_t                steps = n->durationMs;
+
+    steps = RTC_EXACT_MILLIS_TO_STEPS( steps );
+    if( steps == 0 ) steps = 1;
+
+    if( n->frequency )
+        _toneTimers[channel]->begin( n->frequency, true );
+    else
+        _toneTimers[channel]->end();
+
+    t->endStep = fromStep + steps;
+}
+
+static void advanceTone( uint8_t channel )
+{
+    volatile ToneChannel_t *t = &_tones[channel];
+
+    if( t->notes && ++t->index >= t->count && t->repeat ) t->index = 0;
+
+    if( !t->notes || t->index >= t->count )
+        stopTone( channel );
+    else
+        startNote( channel, t->endStep );
+}
+
+// Ends every note that is due and arms the RTC compare for the next one. Runs
+// from the RTC compare interrupt and after a channel is started
+static void serviceTones()
+{
+    for( ;; ) {
+        uint64_t now = stepsRTC() + RTC_COMPARE_MIN_LEAD;
+        uint64_t next = 0;
+
+        for( uint8_t ch = 0; ch < TONE_CHANNELS; ch++ ) {
+            while( _tones[ch].endStep && _tones[ch].endStep <= now )
+                advanceTone( ch );
+
+            if( _tones[ch].endStep &&
+                ( next == 0 || _tones[ch].endStep < next ) )
+                next = _tones[ch].endStep;
+        }
+
+        if( next == 0 ) {
+            disarmCompareRTC();
+            return;
         }
+
+        // The next note may have come due while arming, go around again
+        if( armCompareRTC( next ) == 0 ) return;
     }
 }
 
 bool tone( uint8_t channel, uint32_t frequency, uint32_t durationSeconds )
 {
-    bool rtn = false;
-    _durationCounts = frequency * durationSeconds;
-    if( _durationCounts > 0 ) {
-
-        _counter = 0;
-        _channel = channel;
-
-        switch( channel ) {
-            case 0:
-                Timer.end();
-                Timer.deregisterISR();
-                Timer.registerISR( toneISR );
-                Timer.begin( frequency, true, tc_mode_16_bit, true );
-                rtn = true;
-                break;
-            case 1:
-                Timer1.end();
-                Timer1.deregisterISR();
-                Timer1.registerISR( toneISR );
-                Timer1.begin( frequency, true, tc_mode_16_bit, true );
-                rtn = true;
-                break;
-            case 2:
-                Timer2.end();
-                Timer2.deregisterISR();
-                Timer2.registerISR( toneISR );
-                Timer2.begin( frequency, true, tc_mode_16_bit, true );
-                rtn = true;
-                break;
-            case 3:
-                Timer3.end();
-                Timer3.deregisterISR();
-                Timer3.registerISR( toneISR );
-                Timer3.begin( frequency, true, tc_mode_16_bit, true );
-                rtn = true;
-                break;
-        }
-    }
-    return rtn;
+    if( channel >= TONE_CHANNELS || frequency == 0 || durationSeconds == 0 )
+        return false;
+
+    registerCompareISR( serviceTones );
+
+    ATOMIC_OPERATION( {
+        _tones[channel].notes = 0;
+        _toneTimers[channel]->begin( frequency, true );
+        _tones[channel].endStep =
+            stepsRTC() + (uint64_t)durationSeconds * RTC_STEPS_PER_SEC;
+        serviceTones();
+    } )
+    return true;
+}
+
+// Plays count notes one after the other from the RTC compare interrupt, with
+// repeat the sequence starts over until noTone() is called. The notes must
+// stay valid while the sequence plays
+bool playSequence( uint8_t channel, const Note *notes, uint16_t count,
+                   bool repeat )
+{
+    uint32_t totalMs = 0;
+
+    if( channel >= TONE_CHANNELS || notes == 0 || count == 0 ) return false;
+    for( uint16_t i = 0; i < count; i++ ) totalMs += notes[i].durationMs;
+    if( repeat && totalMs == 0 ) return false;
+
+    registerCompareISR( serviceTones );
+
+    ATOMIC_OPERATION( {
+        _tones[channel].notes = notes;
+        _tones[channel].count = count;
+        _tones[channel].index = 0;
+        _tones[channel].repeat = repeat;
+        startNote( channel, stepsRTC() );
+        serviceTones();
+    } )
+    return true;
+}
+
+void noTone( uint8_t channel )
+{
+    if( channel >= TONE_CHANNELS ) return;
+
+    ATOMIC_OPERATION( {
+        stopTone( channel );
+        serviceTones();
+    } )
+}
+
+bool toneActive( uint8_t channel )
+{
+    return channel < TONE_CHANNELS && _tones[channel].endStep != 0;
 }
@@ -22,6 +22,20 @@
 #include "TimerCounter.h"
 #include "delay.h"
 
+// One channel per timer, channel 0 through 3 drive Timer through Timer3
+#define TONE_CHANNELS 4
+
+// A note of a sequence, a frequency of 0 is a rest
+typedef struct
+{
+    uint16_t frequency;
+    uint16_t durationMs;
+} Note;
+
 bool tone( uint8_t channel, uint32_t frequency, uint32_t durationSeconds );
+bool playSequence( uint8_t channel, const Note *notes, uint16_t count,
+                   bool repeat = false );
+void noTone( uint8_t channel );
+bool toneActive( uint8_t channel );
 
 #endif /* TONE_H_ */
@@ -39,6 +39,11 @@ Uart::Uart( SERCOM *_s, uint8_t _pinRX, uint8_t _pinTX, SercomRXPad _padRX,
     uc_pinRTS = _pinRTS;
     uc_pinCTS = _pinCTS;
     initialized = false;
+    _sleepHeld = false;
+    _rxHoldEn = true;
+    _rxHeld = false;
+    _minClk = -1;
+    _baudrate = 0;
 }
 
 void Uart::begin( unsigned long baudrate )
@@ -68,6 +73,12 @@ void Uart::begin( unsigned long baudrate, uint16_t config )
         *pul_outclrRTS = ul_pinMaskRTS;
     }
 
+    // The 16x oversampled baud rate needs a core clock of at least 16x the
+    // baud, keep the governor from going below it
+    if( _minClk != -1 ) releaseMinCPUClk( (CPUClkSrc_t)_minClk );
+    _minClk = cpuClkForHz( 16 * baudrate );
+    requestMinCPUClk( (CPUClkSrc_t)_minClk );
+
     sercom->initUART( UART_INT_CLOCK, baudrate );
     sercom->initFrame( extractCharSize( config ), LSB_FIRST,
                        extractParity( config ), extractNbStopBit( config ) );
@@ -75,10 +86,17 @@ void Uart::begin( unsigned long baudrate, uint16_t config )
 
     sercom->enableUART();
     initialized = true;
+    holdIdleForRX( _rxHoldEn );
+
+    // BAUD is computed from the core clock, recompute it when that changes
+    _baudrate = baudrate;
+    registerClockNotifier( clockPreChange, clockPostChange, this );
 }
 
 void Uart::end()
 {
+    unregisterClockNotifier( clockPostChange, this );
+
     if( initialized ) {
         sercom->resetUART();
         sercom->endUART();
@@ -91,6 +109,36 @@ void Uart::end()
 
     _rxBuffer.Flush();
     _txBuffer.Flush();
+
+    if( _sleepHeld ) {
+        _sleepHeld = false;
+        releaseSleepLevel( _cpu_ahb_apb );
+    }
+
+    if( _rxHeld ) {
+        _rxHeld = false;
+        releaseSleepLevel( _cpu_ahb_apb );
+    }
+    initialized = false;
+
+    if( _minClk != -1 ) {
+        releaseMinCPUClk( (CPUClkSrc_t)_minClk );
+        _minClk = -1;
+    }
+}
+
+// Holds the idle sleep level while the receiver is enabled, see Uart.h
+void Uart::holdIdleForRX( bool hold )
+{
+    _rxHoldEn = hold;
+    hold = hold && initialized;
+    if( hold == _rxHeld ) return;
+
+    _rxHeld = hold;
+    if( hold )
+        holdSleepLevel( _cpu_ahb_apb );
+    else
+        releaseSleepLevel( _cpu_ahb_apb );
 }
 
 void Uart::flush()
@@ -120,6 +168,25 @@ void Uart::flush()
     }
 }
 
+// Sends everything queued at the old baud rate, including the last byte in
+// the shift register. TXC only sets once a byte has been sent, which holding
+// the sleep level implies.
+void Uart::clockPreChange( void *ctx )
+{
+    Uart *uart = (Uart *)ctx;
+
+    uart->flush();
+    while( uart->_sleepHeld && !uart->sercom->isTransmitCompleteUART() )
+        ;
+}
+
+void Uart::clockPostChange( void *ctx )
+{
+    Uart *uart = (Uart *)ctx;
+
+    uart->sercom->setBaudrateUART( uart->_baudrate );
+}
+
 void Uart::IrqHandler()
 {
     // Handle frame error
@@ -148,11 +215,21 @@ void Uart::IrqHandler()
             sercom->writeDataUART( data );
         }
         else {
-            // Disable this interrupt if empty
+            // Disable this interrupt if empty, wait for the last byte to
+            // leave the shift register
             sercom->disableDataRegisterEmptyInterruptUART();
+            if( _sleepHeld ) sercom->enableTransmitCompleteInterruptUART();
         }
     }
 
+    // Everything is sent, standby no longer cuts a transmission short
+    if( _sleepHeld && sercom->isTransmitCompleteUART() &&
+        !_txBuffer.GetNumObjStored() ) {
+        sercom->disableTransmitCompleteInterruptUART();
+        _sleepHeld = false;
+        releaseSleepLevel( _cpu_ahb_apb );
+    }
+
     if( sercom->isUARTError() ) {
         sercom->acknowledgeUARTError();
         // TODO: if (sercom->isBufferOverflowErrorUART()) ....
@@ -200,6 +277,13 @@ size_t Uart::write( const uint8_t *data, size_t size )
 {
     startAtomicOperation();
     int rtn = _txBuffer.Queue( (uint8_t *)data, size );
+
+    // The SERCOM is clocked from GCLK0 which stops in standby, stay in idle
+    // until the buffer has been sent
+    if( initialized && !_sleepHeld ) {
+        _sleepHeld = true;
+        holdSleepLevel( _cpu_ahb_apb );
+    }
     endAtomicOperation();
     sercom->enableDataRegisterEmptyInterruptUART();
     return rtn;
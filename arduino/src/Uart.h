@@ -45,6 +45,12 @@ class Uart : public Stream
     size_t write( const uint8_t data );
     using Print::write; // pull in write(str) and write(buf, size) from Print
 
+    // The SERCOM runs from GCLK0 which stops in standby, so while the port is
+    // begun the sleep level is held at idle and received bytes are not lost.
+    // Call with false to let the CPU reach standby, bytes arriving there are
+    // dropped.
+    void holdIdleForRX( bool hold );
+
     void IrqHandler();
 
     operator bool()
@@ -67,6 +73,14 @@ class Uart : public Stream
     uint32_t           ul_pinMaskRTS;
     uint8_t            uc_pinCTS;
     bool               initialized;
+    volatile bool      _sleepHeld;
+    bool               _rxHoldEn;
+    bool               _rxHeld;
+    int8_t             _minClk;
+    uint32_t           _baudrate;
+
+    static void clockPreChange( void *ctx );
+    static void clockPostChange( void *ctx );
 
     SercomNumberStopBit extractNbStopBit( uint16_t config );
     SercomUartCharSize  extractCharSize( uint16_t config );
@@ -21,6 +21,8 @@
 #include "atomic.h"
 #include "debug_hooks.h"
 #include "delay.h"
+#include "core_debug.h"
+#include <string.h>
 
 #define WDT_SYNC_BUSY WDT->STATUS.bit.SYNCBUSY
 #define WDT_WAIT_SYNC while( WDT_SYNC_BUSY )
@@ -28,7 +30,9 @@
 uint8_t _isInit = 0;
 void ( *userEarlyWarningISR )( uint32_t ) = 0;
 void ( *userHardFaultISR )( uint32_t ) = 0;
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
 volatile WDT_Debug_t _wdtDebug = {0, 0, 0};
+#endif
 
 /* Note: The WDT runs off the 32768 Hz clock source divided by 32, giving the
  * WDT a 1024 Hz clock source. */
@@ -95,20 +99,21 @@ void disableWDT()
 
 uint8_t clearWDT()
 {
-    _wdtDebug.ok = 0;
+    uint8_t ok = 0;
 
     // Data sheet Section 17.8.8: Writing 0xA5 will reset the WDT counter
     ATOMIC_OPERATION( {
         if( !WDT->STATUS.bit.SYNCBUSY ) {
             WDT->CLEAR.reg = 0xA5;
-            _wdtDebug.ok = 1;
+            ok = 1;
         }
     } )
 
-    _wdtDebug.caller = __get_LR();
-    _wdtDebug.sysTime = millis();
+    CORE_DEBUG_COUNT( _wdtDebug.ok = ok; )
+    CORE_DEBUG_TRACE( _wdtDebug.caller = __get_LR();
+                      _wdtDebug.sysTime = millis(); )
 
-    return _wdtDebug.ok;
+    return ok;
 }
 
 // Warning! Will not return from here.
@@ -146,7 +151,11 @@ void HardFault_IRQHandler( uint32_t rtnAddr )
 
 void getWDTDebugInfo( WDT_Debug_t *wdt )
 {
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
     wdt->caller = _wdtDebug.caller;
     wdt->ok = _wdtDebug.ok;
     wdt->sysTime = _wdtDebug.sysTime;
+#else
+    memset( wdt, 0, sizeof( WDT_Debug_t ) );
+#endif
 }
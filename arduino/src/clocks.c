@@ -28,6 +28,16 @@
     while( !SYSCTRL->PCLKSR.bit.OSC8MRDY ) \
         ;
 
+// Generators in use, GCLK0 is the main clock, GCLK1 the 32 kHz clock and GCLK2
+// belongs to the WDT. The rest are claimed by drivers before they program one.
+static uint8_t _claimedGens =
+    ( 1 << GCLK_GENDIV_ID_GCLK0_Val ) | ( 1 << GCLK_GENDIV_ID_GCLK1_Val ) |
+    ( 1 << GCLK_GENDIV_ID_GCLK2_Val );
+
+// OSC8M runs while the main clock uses it or a peripheral holds it for standby
+static uint8_t _osc8MMain = 0;
+static uint8_t _osc8MStandbyHolds = 0;
+
 void resetGCLK()
 {
     PM->APBAMASK.reg |= PM_APBAMASK_GCLK;
@@ -93,6 +103,31 @@ void disableClkGenerator( uint32_t id )
     return;
 }
 
+// Takes generator id for the caller, returns -1 when another driver has it
+int8_t claimClkGenerator( uint32_t id )
+{
+    int8_t rtn = -1;
+
+    if( id > GCLK_GENDIV_ID_GCLK7_Val ) return -1;
+
+    ATOMIC_OPERATION( {
+        if( !( _claimedGens & ( 1 << id ) ) ) {
+            _claimedGens |= ( 1 << id );
+            rtn = 0;
+        }
+    } )
+
+    return rtn;
+}
+
+void releaseClkGenerator( uint32_t id )
+{
+    if( id <= GCLK_GENDIV_ID_GCLK2_Val || id > GCLK_GENDIV_ID_GCLK7_Val )
+        return;
+
+    ATOMIC_OPERATION( { _claimedGens &= ~( 1 << id ); } )
+}
+
 int8_t initGenericClk( uint32_t genClk, uint32_t id )
 {
     if( genClk > GCLK_CLKCTRL_GEN_GCLK7_Val ) return -1;
@@ -209,19 +244,63 @@ void disableDFLL48()
     SYSCTRL_DFLL_WAIT_SYNC;
 }
 
+// Runs OSC8M at 8 MHz / 2^divBits for the main clock. It stays on demand while
+// a peripheral holds it for standby, see holdOSC8MStandby().
 int8_t initOSC8M( uint32_t divBits )
 {
     if( divBits > 0x3 ) return -1;
 
-    SYSCTRL->OSC8M.bit.ONDEMAND = 0;
-    SYSCTRL->OSC8M.bit.PRESC = divBits;
-    SYSCTRL->OSC8M.bit.ENABLE = 1;
+    // Running on demand it is only ready once requested, wait for it running
+    // continuously and put it back on demand for a standby hold after
+    ATOMIC_OPERATION( {
+        _osc8MMain = 1;
+        SYSCTRL->OSC8M.bit.ONDEMAND = 0;
+        SYSCTRL->OSC8M.bit.PRESC = divBits;
+        SYSCTRL->OSC8M.bit.ENABLE = 1;
+    } )
     SYSCTRL_OSC8M_WAIT_SYNC;
+    ATOMIC_OPERATION( {
+        if( _osc8MStandbyHolds ) SYSCTRL->OSC8M.bit.ONDEMAND = 1;
+    } )
 
     return 0;
 }
 
+// The main clock no longer runs from OSC8M, it is only left enabled (on
+// demand) while held for standby
 void disableOSC8M()
 {
-    SYSCTRL->OSC8M.bit.ENABLE = 0;
+    ATOMIC_OPERATION( {
+        _osc8MMain = 0;
+        if( !_osc8MStandbyHolds ) SYSCTRL->OSC8M.bit.ENABLE = 0;
+    } )
+}
+
+// Keeps OSC8M available to a peripheral in standby, running on demand so it
+// only starts when the peripheral requests a clock. Holds are counted and
+// survive main clock changes, initOSC8M() may still change the prescaler.
+void holdOSC8MStandby()
+{
+    ATOMIC_OPERATION( {
+        if( _osc8MStandbyHolds < 0xFF ) _osc8MStandbyHolds++;
+        SYSCTRL->OSC8M.bit.ONDEMAND = 1;
+        SYSCTRL->OSC8M.bit.RUNSTDBY = 1;
+        SYSCTRL->OSC8M.bit.ENABLE = 1;
+    } )
+}
+
+// Releases a hold, once none are left OSC8M goes back to what the main clock
+// needs: always on if it runs from OSC8M, disabled otherwise
+void releaseOSC8MStandby()
+{
+    ATOMIC_OPERATION( {
+        if( _osc8MStandbyHolds ) _osc8MStandbyHolds--;
+        if( !_osc8MStandbyHolds ) {
+            SYSCTRL->OSC8M.bit.RUNSTDBY = 0;
+            if( _osc8MMain )
+                SYSCTRL->OSC8M.bit.ONDEMAND = 0;
+            else
+                SYSCTRL->OSC8M.bit.ENABLE = 0;
+        }
+    } )
 }
@@ -0,0 +1,70 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef CORE_DEBUG_H_
+#define CORE_DEBUG_H_
+
+// How much bookkeeping the timing paths (stepsRTC, getCPUTicks, micros,
+// delays and clearWDT) leave behind for getCoreDebugInfo(), set with
+// CORE_DEBUG_LEVEL on the make command line or in config.mk
+//
+//   CORE_DEBUG_OFF      - nothing is recorded, getCoreDebugInfo() reads zeros
+//   CORE_DEBUG_COUNTERS - only the inside flags and event counters and flags
+//   CORE_DEBUG_FULL     - also snapshots of the register reads, working
+//                         values and results of the last call
+//
+// Added cycles per call on the Cortex-M0+, counted from its instruction
+// timings (1 cycle per ALU op, 2 per load or store, a 64 bit field takes two
+// stores) for the stores each level adds, at zero flash wait states. They are
+// estimates, not measurements; each literal load of a debug struct's address
+// costs one more cycle at 48 MHz with one wait state.
+//
+//   path                     COUNTERS   FULL
+//   stepsRTC()                  ~12      ~20
+//   getCPUTicks()               ~14      ~18
+//   micros()                     ~8      ~14      (+ getCPUTicks())
+//   delayMicroseconds()          ~8      ~12      (+ delayCPUTicks())
+//   delayCPUTicks()             ~10      ~18      + 4 per poll at FULL
+//   delayRTCSteps()             ~10      ~18      + 8 per poll at FULL,
+//                                                 + 5 per sleep from COUNTERS
+//   RTC_IRQHandler()            ~13      ~15
+//   clearWDT()                   ~4       ~7      + a millis() call at FULL
+//
+// OFF adds nothing. The level is recorded in the build directory so changing
+// it rebuilds every object, see arduino/Makefile.
+#define CORE_DEBUG_OFF 0
+#define CORE_DEBUG_COUNTERS 1
+#define CORE_DEBUG_FULL 2
+
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL CORE_DEBUG_FULL
+#endif
+
+#if CORE_DEBUG_LEVEL >= CORE_DEBUG_COUNTERS
+#define CORE_DEBUG_COUNT( ... ) __VA_ARGS__
+#else
+#define CORE_DEBUG_COUNT( ... )
+#endif
+
+#if CORE_DEBUG_LEVEL >= CORE_DEBUG_FULL
+#define CORE_DEBUG_TRACE( ... ) __VA_ARGS__
+#else
+#define CORE_DEBUG_TRACE( ... )
+#endif
+
+#endif /* CORE_DEBUG_H_ */
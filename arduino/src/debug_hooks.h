@@ -23,6 +23,7 @@
 #include "WDT.h"
 #include "RTC.h"
 #include "SysTick.h"
+#include "core_debug.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -20,24 +20,56 @@
 #include "RTC.h"
 #include "SysTick.h"
 #include "atomic.h"
+#include "fastdiv.h"
+#include "core_debug.h"
+#include <string.h>
 
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
 volatile Micros_Debug_t      _microsDebug = {0, 0, 0};
 volatile DelayMicros_Debug_t _delayMicrosDebug = {0, 0};
+#endif
 
 void getMicrosDebugInfo( Micros_Debug_t *mic, DelayMicros_Debug_t *dMic )
 {
+#if CORE_DEBUG_LEVEL > CORE_DEBUG_OFF
     mic->rtnMicros = _microsDebug.rtnMicros;
     mic->tix = _microsDebug.tix;
     mic->inside = _microsDebug.inside;
 
     dMic->mic = _delayMicrosDebug.mic;
     dMic->inside = _delayMicrosDebug.inside;
+#else
+    memset( mic, 0, sizeof( Micros_Debug_t ) );
+    memset( dMic, 0, sizeof( DelayMicros_Debug_t ) );
+#endif
+}
+
+// CPU ticks per microsecond and its reciprocal for the current SystemCoreClock,
+// rebuilt whenever the clock changes so micros() never divides
+static FastDiv_t _ticksToMicros = {0, 0, 0};
+static uint32_t  _ticksPerMicro = 1;
+static uint32_t  _reciprocalClock = 0;
+
+void refreshClockReciprocals()
+{
+    uint32_t perMicro = SystemCoreClock / 1000000ul;
+    if( perMicro == 0 ) perMicro = 1;
+
+    ATOMIC_OPERATION( {
+        fastDivInit( &_ticksToMicros, perMicro );
+        _ticksPerMicro = perMicro;
+        _reciprocalClock = SystemCoreClock;
+    } )
 }
 
 uint32_t millis()
 {
+    // Only the low 32 bits of the result are returned, so the exact conversion
+    // can be done with 32 bit multiplies on the truncated step count
     uint64_t steps = stepsRTC();
-    return ( uint32_t )( RTC_EXACT_STEPS_TO_MILLIS( steps ) & 0xFFFFFFFF );
+    uint32_t high = ( uint32_t )( steps >> 12 );
+    uint32_t low = (uint32_t)steps & 0xFFF;
+    return ( high * 125 ) + ( ( low * 125 ) >> 12 );
 }
 
 void delay( uint32_t ms )
@@ -47,29 +79,27 @@ void delay( uint32_t ms )
 
 uint32_t micros()
 {
-    _microsDebug.inside = 1;
-    _microsDebug.tix = getCPUTicks();
-
-    if( SystemCoreClock > 8000000ul )
-        _microsDebug.rtnMicros =
-            ( uint32_t )( ( _microsDebug.tix / 48 ) & 0xFFFFFFFF );
-    else
-        _microsDebug.rtnMicros = ( uint32_t )(
-            ( _microsDebug.tix >> ( SystemCoreClock >> 21 ) ) & 0xFFFFFFFF );
-
-    _microsDebug.inside = 0;
-    return _microsDebug.rtnMicros;
+    uint64_t tix;
+    uint32_t us;
+
+    CORE_DEBUG_COUNT( _microsDebug.inside = 1; )
+    if( _reciprocalClock != SystemCoreClock ) refreshClockReciprocals();
+
+    tix = getCPUTicks();
+    us = ( uint32_t )( fastDiv( &_ticksToMicros, tix ) & 0xFFFFFFFF );
+
+    CORE_DEBUG_TRACE( _microsDebug.tix = tix; _microsDebug.rtnMicros = us; )
+    CORE_DEBUG_COUNT( _microsDebug.inside = 0; )
+    return us;
 }
 
 void delayMicroseconds( uint32_t us )
 {
-    _delayMicrosDebug.inside = 1;
-    _delayMicrosDebug.mic = (uint64_t)us;
+    CORE_DEBUG_COUNT( _delayMicrosDebug.inside = 1; )
+    CORE_DEBUG_TRACE( _delayMicrosDebug.mic = (uint64_t)us; )
+    if( _reciprocalClock != SystemCoreClock ) refreshClockReciprocals();
 
-    if( SystemCoreClock > 8000000ul )
-        delayCPUTicks( _delayMicrosDebug.mic * 48 );
-    else
-        delayCPUTicks( _delayMicrosDebug.mic << ( SystemCoreClock >> 21 ) );
+    delayCPUTicks( (uint64_t)us * _ticksPerMicro );
 
-    _delayMicrosDebug.inside = 0;
+    CORE_DEBUG_COUNT( _delayMicrosDebug.inside = 0; )
 }
@@ -44,6 +44,7 @@ uint32_t millis();
 void     delay( uint32_t ms );
 uint32_t micros();
 void     delayMicroseconds( uint32_t us );
+void     refreshClockReciprocals();
 
 #ifdef __cplusplus
 }
@@ -130,32 +130,71 @@ void interruptlowPowerMode( uint8_t en )
     _lowPowerModeActive = en;
 }
 
+// True when the EIC runs from the 32kHz clock and keeps detecting in standby
+uint8_t interruptLowPowerModeActive()
+{
+    return _enabled && _lowPowerModeActive;
+}
+
+// Returns the EIC line for the pin, mapped directly from the data sheet, or -1
+// if the pin has no external interrupt
+static int8_t pinToEXTINT( uint32_t pin )
+{
+    uint32_t shifter = gArduinoPins[pin].pin;
+
+    if( gArduinoPins[pin].extInt == -1 ) return -1;
+
+    if( shifter < 16 )
+        return shifter;
+    else if( shifter >= 16 && shifter < 24 )
+        return shifter - 16;
+    else if( shifter >= 24 && shifter < 28 )
+        return shifter - 12;
+    else if( shifter >= 28 && shifter < 32 )
+        return shifter - 20;
+
+    return -1;
+}
+
+// Configures the sense mode of an EIC line, the bottom 8 lines are in the
+// first configuration register and the top 8 lines in the second
+static void setSense( uint8_t extInt, uint32_t interruptMode )
+{
+    uint8_t  config = ( extInt > 7 ? 1 : 0 );
+    uint32_t pos = ( extInt & 0x7 ) * 4;
+
+    EIC->CONFIG[config].reg &= ~( EIC_CONFIG_SENSE0_Msk << pos );
+    switch( interruptMode ) {
+        case LOW:
+            EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_LOW_Val << pos;
+            break;
+        case HIGH:
+            EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_HIGH_Val << pos;
+            break;
+        case CHANGE:
+            EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_BOTH_Val << pos;
+            break;
+        case FALLING:
+            EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_FALL_Val << pos;
+            break;
+        case RISING:
+            EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_RISE_Val << pos;
+            break;
+    }
+}
+
 // Sets the pin up for external interrupt mode, registers the callback function
 // with that interrupt vector if the callback is not null. Will overwrite
 // previous callback function if there was one.
 void attachInterrupt( uint32_t pin, void ( *callback )(),
                       uint32_t interruptMode )
 {
-    uint32_t shifter = gArduinoPins[pin].pin;
+    int8_t   shifter = pinToEXTINT( pin );
     uint32_t EICBit = 0;
-    uint8_t  isNMI = 0;
+    uint8_t  isNMI = ( gArduinoPins[pin].pin == 8 );
 
     // No external interrupt on this pin
-    if( gArduinoPins[pin].extInt == -1 ) return;
-
-    // Corresponding EIC interrupt number by SAM PORTA pins, mapped directly
-    // from the data sheet
-    if( shifter < 16 ) {
-        if( shifter == 8 ) isNMI = 1;
-    }
-    else if( shifter >= 16 && shifter < 24 )
-        shifter -= 16;
-    else if( shifter >= 24 && shifter < 28 )
-        shifter -= 12;
-    else if( shifter >= 28 && shifter < 32 )
-        shifter -= 20;
-    else
-        return;
+    if( shifter == -1 ) return;
 
     if( !isNMI ) {
         EICBit = 1 << shifter;
@@ -171,40 +210,7 @@ void attachInterrupt( uint32_t pin, void ( *callback )(),
         // Ensure that the callback is not null
         if( callback ) {
             ISRcallback[shifter] = callback;
-
-            // Figure out which of the two configuration registers we must use
-            // (bottom configuration for bottom 8 external interrupts, top
-            // configuration for top 8 external interrupts)
-            uint8_t config = ( shifter > 7 ? 1 : 0 );
-
-            // Get the bit mask offset for the bits in the configuration
-            // register
-            uint32_t pos = shifter * 4;
-            if( pos > 28 ) pos /= 2;
-
-            // Configure the interrupt mode
-            EIC->CONFIG[config].reg &= ~( EIC_CONFIG_SENSE0_Msk << pos );
-            switch( interruptMode ) {
-                case LOW:
-                    EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_LOW_Val << pos;
-                    break;
-                case HIGH:
-                    EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_HIGH_Val
-                                               << pos;
-                    break;
-                case CHANGE:
-                    EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_BOTH_Val
-                                               << pos;
-                    break;
-                case FALLING:
-                    EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_FALL_Val
-                                               << pos;
-                    break;
-                case RISING:
-                    EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_RISE_Val
-                                               << pos;
-                    break;
-            }
+            setSense( shifter, interruptMode );
         }
 
         // Enable the interrupt
@@ -235,26 +241,12 @@ void attachInterrupt( uint32_t pin, void ( *callback )(),
 // the callback associated with that pin.
 void detachInterrupt( uint32_t pin )
 {
-    uint32_t shifter = gArduinoPins[pin].pin;
+    int8_t   shifter = pinToEXTINT( pin );
     uint32_t EICBit;
-    uint8_t  isNMI = 0;
+    uint8_t  isNMI = ( gArduinoPins[pin].pin == 8 );
 
     // No external interrupt on this pin
-    if( gArduinoPins[pin].extInt == -1 ) return;
-
-    // Corresponding EIC interrupt number by SAM PORTA pins, mapped directly
-    // from the data sheet
-    if( shifter < 16 ) {
-        if( shifter == 8 ) isNMI = 1;
-    }
-    else if( shifter >= 16 && shifter < 24 )
-        shifter -= 16;
-    else if( shifter >= 24 && shifter < 28 )
-        shifter -= 12;
-    else if( shifter >= 28 && shifter < 32 )
-        shifter -= 20;
-    else
-        return;
+    if( shifter == -1 ) return;
 
     if( !isNMI ) {
         EICBit = 1 << shifter;
@@ -275,6 +267,34 @@ void detachInterrupt( uint32_t pin )
     pinMode( pin, INPUT );
 }
 
+// Sets the pin up to drive an event instead of an interrupt, returns the EIC
+// line (see EVENT_GEN_EIC) or -1 if the pin can't generate events. With HIGH
+// or LOW sense the event follows the level of the pin.
+int8_t attachEventOutput( uint32_t pin, uint32_t sense )
+{
+    int8_t extInt = pinToEXTINT( pin );
+
+    // The NMI can't generate events
+    if( extInt == -1 || gArduinoPins[pin].pin == 8 ) return -1;
+
+    if( !_enabled ) __initialize( 0 );
+
+    pinMode( pin, gArduinoPins[pin].extInt );
+    setSense( extInt, sense );
+    EIC->EVCTRL.reg |= ( 1 << extInt );
+
+    return extInt;
+}
+
+void detachEventOutput( uint32_t pin )
+{
+    int8_t extInt = pinToEXTINT( pin );
+    if( extInt == -1 || gArduinoPins[pin].pin == 8 ) return;
+
+    EIC->EVCTRL.reg &= ~( 1 << extInt );
+    pinMode( pin, INPUT );
+}
+
 void EIC_Handler()
 {
     uint32_t flags = ( EIC->INTFLAG.reg & EIC->INTENSET.reg );
@@ -34,9 +34,12 @@ extern "C" {
 
 void disableExternalInterrupts();
 void interruptlowPowerMode( uint8_t enable );
+uint8_t interruptLowPowerModeActive();
 void attachInterrupt( uint32_t pin, void ( *callback )(),
                       uint32_t interruptMode );
 void detachInterrupt( uint32_t pin );
+int8_t attachEventOutput( uint32_t pin, uint32_t sense );
+void   detachEventOutput( uint32_t pin );
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,91 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "fastdiv.h"
+
+// The divisor d is split into 2^p * o with o odd, so n / d == ( n >> p ) / o.
+// For o > 1 the quotient of x = n >> p uses the round up method of Granlund
+// and Montgomery ("Division by Invariant Integers using Multiplication", 1994,
+// figure 4.1) with N = 64 and l = ceil( log2( o ) ):
+//
+//   m' = floor( 2^64 * ( 2^l - o ) / o ) + 1
+//   t  = floor( m' * x / 2^64 )
+//   q  = ( t + ( ( x - t ) >> 1 ) ) >> ( l - 1 )
+//
+// Their theorem 4.2 gives q == floor( x / o ) for every 0 <= x < 2^64 when
+// 2^( l - 1 ) < o <= 2^l, which holds for any odd o > 1. The ( x - t ) >> 1
+// form adds the implied 2^64 bit of the 65 bit multiplier without overflow, as
+// t <= x. The result is therefore exact over the full 64 bit range, not an
+// approximation.
+void fastDivInit( FastDiv_t *fd, uint32_t divisor )
+{
+    uint8_t  l = 0;
+    uint64_t rem, q = 0;
+
+    if( divisor == 0 ) divisor = 1;
+
+    fd->preShift = 0;
+    while( !( divisor & 1 ) ) {
+        divisor >>= 1;
+        fd->preShift++;
+    }
+
+    fd->magic = 0;
+    fd->postShift = 0;
+    if( divisor == 1 ) return;
+
+    while( ( 1ull << l ) < divisor ) l++;
+
+    // 2^64 * ( 2^l - o ) / o by long division, the remainder stays below
+    // 2^33 so it never overflows
+    rem = ( 1ull << l ) - divisor;
+    for( uint8_t i = 0; i < 64; i++ ) {
+        rem <<= 1;
+        q <<= 1;
+        if( rem >= divisor ) {
+            rem -= divisor;
+            q |= 1;
+        }
+    }
+
+    fd->magic = q + 1;
+    fd->postShift = l - 1;
+}
+
+uint64_t fastDiv( const FastDiv_t *fd, uint64_t n )
+{
+    n >>= fd->preShift;
+    if( fd->magic == 0 ) return n;
+
+    uint64_t t = mulHigh64( fd->magic, n );
+    return ( t + ( ( n - t ) >> 1 ) ) >> fd->postShift;
+}
+
+// High 64 bits of the 128 bit product from four 32 x 32 bit products
+uint64_t mulHigh64( uint64_t a, uint64_t b )
+{
+    uint32_t a0 = (uint32_t)a, a1 = ( uint32_t )( a >> 32 );
+    uint32_t b0 = (uint32_t)b, b1 = ( uint32_t )( b >> 32 );
+    uint64_t p00 = (uint64_t)a0 * b0;
+    uint64_t p01 = (uint64_t)a0 * b1;
+    uint64_t p10 = (uint64_t)a1 * b0;
+    uint64_t p11 = (uint64_t)a1 * b1;
+    uint64_t mid = ( p00 >> 32 ) + (uint32_t)p01 + (uint32_t)p10;
+
+    return p11 + ( p01 >> 32 ) + ( p10 >> 32 ) + ( mid >> 32 );
+}
@@ -0,0 +1,44 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef FASTDIV_H_
+#define FASTDIV_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Precomputed reciprocal for dividing 64 bit values by a 32 bit constant with
+// multiplies and shifts, the M0+ has no hardware divider
+typedef struct
+{
+    uint64_t magic;     // Reciprocal, 0 when the divisor is a power of two
+    uint8_t  preShift;  // Power of two factor of the divisor
+    uint8_t  postShift; // ceil( log2( odd factor ) ) - 1
+} FastDiv_t;
+
+void     fastDivInit( FastDiv_t *fd, uint32_t divisor );
+uint64_t fastDiv( const FastDiv_t *fd, uint64_t n );
+uint64_t mulHigh64( uint64_t a, uint64_t b );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTDIV_H_ */
@@ -0,0 +1,170 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "governor.h"
+#include "RTC.h"
+#include "atomic.h"
+
+// The clocks from slowest to fastest, decisions work on the index (rank)
+#define GOVERNOR_RANKS 5
+static const CPUClkSrc_t _clkByRank[GOVERNOR_RANKS] = {
+    cpu_clk_oscm1, cpu_clk_oscm2, cpu_clk_oscm4, cpu_clk_oscm8, cpu_clk_dfll48};
+static const uint8_t _mhzByRank[GOVERNOR_RANKS] = {1, 2, 4, 8, 48};
+
+// Minimum clock requests from drivers, counted per rank
+static volatile uint8_t _clkRequests[GOVERNOR_RANKS];
+
+static uint8_t          _governorEn = 0;
+static GovernorPolicy_t _policy = governor_ondemand;
+static uint64_t         _sampleStart = 0;
+static uint64_t         _sampleAwake = 0;
+static uint64_t         _sampleAsleep = 0;
+
+static uint8_t clkRank( CPUClkSrc_t src )
+{
+    return src == cpu_clk_dfll48 ? GOVERNOR_RANKS - 1 : cpu_clk_oscm1 - src;
+}
+
+// Decides the clock for the next sample period from the utilization measured
+// at the current clock, kept free of hardware access so it can be simulated
+CPUClkSrc_t governorDecide( GovernorPolicy_t policy, CPUClkSrc_t current,
+                            uint16_t busyPermille, CPUClkSrc_t minimum )
+{
+    uint8_t rank = clkRank( current );
+    uint8_t target = rank;
+
+    switch( policy ) {
+        case governor_powersave: target = 0; break;
+        case governor_performance: target = GOVERNOR_RANKS - 1; break;
+        case governor_ondemand:
+
+            // Straight to full speed under load, back down a step at a time
+            if( busyPermille >= GOVERNOR_UP_PERMILLE )
+                target = GOVERNOR_RANKS - 1;
+            else if( busyPermille <= GOVERNOR_DOWN_PERMILLE && rank > 0 ) {
+                uint32_t scaled = (uint32_t)busyPermille * _mhzByRank[rank] /
+                                  _mhzByRank[rank - 1];
+                if( scaled < GOVERNOR_UP_PERMILLE ) target = rank - 1;
+            }
+            break;
+    }
+
+    if( target < clkRank( minimum ) ) target = clkRank( minimum );
+    return _clkByRank[target];
+}
+
+// The slowest clock at or above hz
+CPUClkSrc_t cpuClkForHz( uint32_t hz )
+{
+    for( uint8_t rank = 0; rank < GOVERNOR_RANKS - 1; rank++ )
+        if( _mhzByRank[rank] * 1000000ul >= hz ) return _clkByRank[rank];
+    return cpu_clk_dfll48;
+}
+
+CPUClkSrc_t currentCPUClk()
+{
+    return cpuClkForHz( SystemCoreClock );
+}
+
+// The fastest clock any driver has requested, the slowest clock if none has
+CPUClkSrc_t minCPUClk()
+{
+    for( uint8_t rank = GOVERNOR_RANKS - 1; rank > 0; rank-- )
+        if( _clkRequests[rank] ) return _clkByRank[rank];
+    return _clkByRank[0];
+}
+
+// Keeps the governor at src or faster until released, e.g. a Uart holds the
+// clock its baud rate needs. Requests are counted, each needs its own release.
+// With the governor running a faster clock is switched to right away, so call
+// it from thread mode before configuring anything that depends on the clock.
+void requestMinCPUClk( CPUClkSrc_t src )
+{
+    uint8_t rank = clkRank( src );
+
+    ATOMIC_OPERATION( {
+        if( _clkRequests[rank] < 0xFF ) _clkRequests[rank]++;
+    } )
+
+    if( _governorEn && clkRank( currentCPUClk() ) < rank ) changeCPUClk( src );
+}
+
+void releaseMinCPUClk( CPUClkSrc_t src )
+{
+    uint8_t rank = clkRank( src );
+
+    ATOMIC_OPERATION( {
+        if( _clkRequests[rank] ) _clkRequests[rank]--;
+    } )
+}
+
+void enableGovernor( GovernorPolicy_t policy )
+{
+    _policy = policy;
+    _governorEn = 1;
+
+    _sampleStart = stepsRTC();
+    getAwakeSleepSteps( &_sampleAwake, &_sampleAsleep );
+
+    // Powersave and performance don't need to wait for a sample
+    CPUClkSrc_t target =
+        governorDecide( policy, currentCPUClk(), 500, minCPUClk() );
+    if( policy != governor_ondemand && target != currentCPUClk() )
+        changeCPUClk( target );
+}
+
+void disableGovernor()
+{
+    _governorEn = 0;
+}
+
+// Call regularly from thread mode, main() does after each loop(). Once a
+// sample period has passed the utilization over it picks the next clock.
+void governorUpdate()
+{
+    uint64_t now, awake, asleep, busy, total;
+
+    if( !_governorEn ) return;
+
+    now = stepsRTC();
+    if( now - _sampleStart < GOVERNOR_SAMPLE_STEPS ) return;
+
+    getAwakeSleepSteps( &awake, &asleep );
+    busy = awake - _sampleAwake;
+    total = busy + ( asleep - _sampleAsleep );
+
+    _sampleStart = now;
+    _sampleAwake = awake;
+    _sampleAsleep = asleep;
+
+    // A loop() that ran or slept for long makes a long sample, scale it down
+    // so the per mille fits 32 bit math
+    while( total > 0x3FFFFF ) {
+        busy >>= 1;
+        total >>= 1;
+    }
+
+    uint16_t permille = 1000;
+    if( total )
+        permille = ( uint16_t )( (uint32_t)busy * 1000 / (uint32_t)total );
+
+    CPUClkSrc_t current = currentCPUClk();
+    CPUClkSrc_t target =
+        governorDecide( _policy, current, permille, minCPUClk() );
+    if( target != current ) changeCPUClk( target );
+}
@@ -0,0 +1,62 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef GOVERNOR_H_
+#define GOVERNOR_H_
+
+#include <stdint.h>
+#include "sleep.h"
+
+// The governor samples CPU utilization over at least this many RTC steps
+// (~100 ms) before deciding on a clock
+#define GOVERNOR_SAMPLE_STEPS 3277
+
+// Busy per mille at or above which ondemand goes to full speed, and at or
+// below which it considers the next slower clock. A slower clock is only taken
+// when the load scaled to it stays under the up threshold, so the two never
+// chase each other.
+#define GOVERNOR_UP_PERMILLE 800
+#define GOVERNOR_DOWN_PERMILLE 300
+
+typedef enum
+{
+    governor_powersave,   // Slowest clock the drivers allow
+    governor_ondemand,    // Follow the load with hysteresis
+    governor_performance  // Always 48 MHz
+} GovernorPolicy_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void        enableGovernor( GovernorPolicy_t policy );
+void        disableGovernor();
+void        governorUpdate();
+void        requestMinCPUClk( CPUClkSrc_t src );
+void        releaseMinCPUClk( CPUClkSrc_t src );
+CPUClkSrc_t minCPUClk();
+CPUClkSrc_t currentCPUClk();
+CPUClkSrc_t cpuClkForHz( uint32_t hz );
+CPUClkSrc_t governorDecide( GovernorPolicy_t policy, CPUClkSrc_t current,
+                            uint16_t busyPermille, CPUClkSrc_t minimum );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GOVERNOR_H_ */
@@ -28,6 +28,12 @@ void initVariant()
 // Initialize C library
 extern "C" void __libc_init_array( void );
 
+// Bytes waiting on the serial port are work for loop(), don't sleep on them
+static int serialHasWork()
+{
+    return Serial.available() > 0;
+}
+
 int main( void )
 {
     initRTC();
@@ -41,9 +47,14 @@ int main( void )
 
     setup();
 
+    // With enableTicklessIdle() the CPU sleeps between calls to loop() until
+    // an interrupt or RTC alarm, with enableGovernor() the core clock follows
+    // the load
     for( ;; ) {
         loop();
         if( serialEventRun ) serialEventRun();
+        governorUpdate();
+        ticklessIdle( serialHasWork );
     }
 
     return 0;
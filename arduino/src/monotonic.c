@@ -0,0 +1,105 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "monotonic.h"
+#include "SysTick.h"
+#include "RTC.h"
+#include "atomic.h"
+#include "fastdiv.h"
+
+// While awake the clock is extrapolated from the last anchor with SysTick,
+// which resolves one CPU tick. SysTick restarts from zero in standby and on a
+// CPU clock change, so whenever its epoch changes the clock is anchored again
+// to the RTC, which keeps counting through standby at 30.5 us resolution. The
+// anchor is also refreshed once a second of CPU ticks so the drift of the CPU
+// clock against the RTC stays small. The anchor is always the RTC value, when
+// the CPU clock ran fast the output holds at the last value handed out until
+// the new extrapolation catches up, so the clock never steps backwards.
+static uint64_t  _anchorTicks = 0;    // Monotonic ticks at the anchor
+static uint64_t  _anchorCPUTicks = 0; // getCPUTicks() at the anchor
+static uint32_t  _anchorEpoch = 0;    // sysTickEpoch() of the anchor
+static uint32_t  _cpuTickScale = 1;   // Monotonic ticks per CPU tick
+static uint32_t  _anchorSpan = 0;     // CPU ticks before the anchor refreshes
+static uint64_t  _lastTicks = 0;      // Largest value returned so far
+static uint8_t   _anchored = 0;
+static FastDiv_t _ticksToNanos = {0, 0, 0};
+
+// Anchors the clock to the RTC at CPU tick cpu. An estimate extrapolated from
+// the previous anchor is kept when it falls inside the current RTC step, so a
+// refresh doesn't lose the sub step phase. One that ran ahead is not, so the
+// error of a fast CPU clock can't build up across refreshes.
+static void anchorToRTC( uint64_t estimate, uint64_t cpu )
+{
+    uint64_t ticks = MONOTONIC_STEPS_TO_TICKS( stepsRTC() );
+    if( estimate >= ticks &&
+        estimate < ticks + MONOTONIC_STEPS_TO_TICKS( 1ull ) )
+        ticks = estimate;
+
+    _anchorTicks = ticks;
+    _anchorCPUTicks = cpu;
+    _anchorEpoch = sysTickEpoch();
+
+    // The core clocks are all whole divisors of 48 MHz
+    _cpuTickScale = MONOTONIC_TICKS_PER_SEC / SystemCoreClock;
+    if( _cpuTickScale == 0 ) _cpuTickScale = 1;
+    _anchorSpan = SystemCoreClock;
+
+    if( !_anchored ) fastDivInit( &_ticksToNanos, 6 );
+    _anchored = 1;
+}
+
+uint64_t monotonicTicks()
+{
+    uint64_t ticks;
+
+    ATOMIC_OPERATION( {
+        // Reading the CPU ticks may restart SysTick, so the epoch is compared
+        // after it
+        uint64_t cpu = getCPUTicks();
+        if( !_anchored || _anchorEpoch != sysTickEpoch() ||
+            cpu < _anchorCPUTicks )
+            anchorToRTC( 0, cpu );
+        else {
+            ticks = _anchorTicks + ( cpu - _anchorCPUTicks ) * _cpuTickScale;
+            if( cpu - _anchorCPUTicks >= _anchorSpan )
+                anchorToRTC( ticks, cpu );
+        }
+
+        ticks = _anchorTicks + ( cpu - _anchorCPUTicks ) * _cpuTickScale;
+        if( ticks < _lastTicks ) ticks = _lastTicks;
+        _lastTicks = ticks;
+    } )
+
+    return ticks;
+}
+
+uint64_t monotonicNanos()
+{
+    // ticks * 1000 / 48 == ticks * 125 / 6
+    uint64_t ticks = monotonicTicks();
+    return fastDiv( &_ticksToNanos, ticks * 125 );
+}
+
+void anchorMonotonicClock()
+{
+    ATOMIC_OPERATION( {
+        uint64_t cpu = getCPUTicks();
+        if( !_anchored || _anchorEpoch != sysTickEpoch() )
+            anchorToRTC( 0, cpu );
+    } )
+}
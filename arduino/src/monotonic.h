@@ -0,0 +1,41 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MONOTONIC_H_
+#define MONOTONIC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The monotonic clock always counts at the 48 MHz core rate, whatever the CPU
+// clock is, so one RTC step is exactly 46875 / 32 monotonic ticks
+#define MONOTONIC_TICKS_PER_SEC 48000000ul
+#define MONOTONIC_STEPS_TO_TICKS( x ) ( ( ( x ) * 46875 ) >> 5 )
+
+uint64_t monotonicTicks();
+uint64_t monotonicNanos();
+void     anchorMonotonicClock();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONOTONIC_H_ */
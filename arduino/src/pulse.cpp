@@ -0,0 +1,132 @@
+/*
+  Copyright (c) 2015 Arduino LLC.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+
+// Timer used to capture pulses. The capture runs in 32 bit mode, so this must
+// be an even timer and its odd partner is also taken.
+#ifndef PULSE_CAPTURE_TIMER
+#define PULSE_CAPTURE_TIMER Timer2
+#endif
+
+static int8_t   _pulseChannel = -1;
+static uint32_t _pulsePin = 0;
+static void ( *_pulseCallback )( uint32_t, uint32_t ) = NULL;
+
+// Routes the pin through the EIC and event system into the capture timer. The
+// timer restarts on the start of each pulse, capturing the period into CC0 and
+// the pulse width into CC1 at its end.
+static int8_t beginPulseCapture( uint32_t pin, uint32_t state,
+                                 bool useInterrupts )
+{
+    if( _pulseChannel != -1 ) return -1;
+
+    int8_t extInt = attachEventOutput( pin, HIGH );
+    if( extInt == -1 ) return -1;
+
+    _pulseChannel = allocEventChannel();
+    if( _pulseChannel == -1 ) {
+        detachEventOutput( pin );
+        return -1;
+    }
+    _pulsePin = pin;
+
+    routeEvent( _pulseChannel, EVENT_GEN_EIC( extInt ), event_path_async,
+                event_edge_none );
+    PULSE_CAPTURE_TIMER.beginCapture( tc_capture_ppw, tc_mode_32_bit,
+                                      TC_CTRLA_PRESCALER_DIV1_Val,
+                                      ( state == LOW ), useInterrupts );
+    addEventUser( _pulseChannel, PULSE_CAPTURE_TIMER.getEventUser() );
+
+    return 0;
+}
+
+static void endPulseCapture()
+{
+    if( _pulseChannel == -1 ) return;
+
+    freeEventChannel( _pulseChannel );
+    _pulseChannel = -1;
+    PULSE_CAPTURE_TIMER.deregisterISR();
+    PULSE_CAPTURE_TIMER.end();
+    detachEventOutput( _pulsePin );
+}
+
+static void pulseISR()
+{
+    uint32_t width = PULSE_CAPTURE_TIMER.getCapture( 1 );
+    uint32_t period = PULSE_CAPTURE_TIMER.getCapture( 0 );
+
+    if( _pulseCallback != NULL )
+        _pulseCallback( clockCyclesToMicroseconds( width ),
+                        clockCyclesToMicroseconds( period ) );
+}
+
+/* Measures the length (in microseconds) of a pulse on the pin; state is HIGH
+ * or LOW, the type of pulse to measure. The pulse is captured in hardware so
+ * the result is exact to a clock cycle up to ~89 seconds at 48 MHz. Returns 0
+ * if no complete pulse starts and ends within the timeout. */
+uint32_t pulseIn( uint32_t pin, uint32_t state, uint32_t timeout )
+{
+    uint32_t start = micros();
+    uint32_t width = 0;
+
+    if( beginPulseCapture( pin, state, false ) != 0 ) return 0;
+
+    // Wait for any pulse already in progress to end, so the first capture is
+    // of a whole pulse
+    while( digitalRead( pin ) == state ) {
+        if( micros() - start >= timeout ) goto PULSE_DONE;
+    }
+    PULSE_CAPTURE_TIMER.getCapture( 1 );
+
+    while( !PULSE_CAPTURE_TIMER.captureReady( 1 ) ) {
+        if( micros() - start >= timeout ) goto PULSE_DONE;
+    }
+    width = clockCyclesToMicroseconds( PULSE_CAPTURE_TIMER.getCapture( 1 ) );
+
+PULSE_DONE:
+    endPulseCapture();
+    return width;
+}
+
+/* Measures every pulse on the pin in the background, callback is called from
+ * the timer interrupt with the width and period of each pulse in
+ * microseconds. Returns -1 if the pin can't be captured or a measurement is
+ * already running. */
+int8_t measurePulseAsync( uint32_t pin, uint32_t state,
+                          void ( *callback )( uint32_t widthUs,
+                                              uint32_t periodUs ) )
+{
+    if( callback == NULL ) return -1;
+
+    _pulseCallback = callback;
+    PULSE_CAPTURE_TIMER.registerISR( pulseISR );
+    if( beginPulseCapture( pin, state, true ) != 0 ) {
+        PULSE_CAPTURE_TIMER.deregisterISR();
+        return -1;
+    }
+
+    return 0;
+}
+
+void endPulseAsync()
+{
+    endPulseCapture();
+    _pulseCallback = NULL;
+}
@@ -24,12 +24,20 @@ extern "C" {
 
 /*
  * \brief Measures the length (in microseconds) of a pulse on the pin; state is
- * HIGH or LOW, the type of pulse to measure.  Works on pulses from 2-3
- * microseconds to 3 minutes in length, but must be called at least a few dozen
- * microseconds before the start of the pulse.
+ * HIGH or LOW, the type of pulse to measure. The pulse is captured in hardware
+ * by PULSE_CAPTURE_TIMER, so the pin must have an external interrupt.
  */
 uint32_t pulseIn( uint32_t pin, uint32_t state, uint32_t timeout );
 
+/*
+ * \brief Measures every pulse on the pin in the background and calls callback
+ * from the timer interrupt with the width and period in microseconds.
+ */
+int8_t measurePulseAsync( uint32_t pin, uint32_t state,
+                          void ( *callback )( uint32_t widthUs,
+                                              uint32_t periodUs ) );
+void   endPulseAsync();
+
 #ifdef __cplusplus
 // Provides a version of pulseIn with a default argument (C++ only)
 uint32_t pulseIn( uint32_t pin, uint32_t state, uint32_t timeout = 1000000L );
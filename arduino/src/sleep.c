@@ -22,13 +22,36 @@
 #include "variant.h"
 #include "SysTick.h"
 #include "delay.h"
+#include "monotonic.h"
+#include "RTC.h"
+#include "atomic.h"
+#include <string.h>
 
-uint8_t  _sleepEn = 1;
-uint32_t _sysUpTimeAccum = 0;
+uint8_t _sleepEn = 1;
+uint8_t _ticklessEn = 0;
 
-volatile uint8_t  _needExitSleep = 0;
-volatile uint8_t  _exitLock = 0;
-volatile uint32_t _sysExitSleepTime = 0;
+// Holds on each idle level, while a level is held the CPU does not sleep any
+// deeper than it
+static volatile uint8_t _sleepHolds[_deep_sleep];
+
+volatile uint8_t _needExitSleep = 0;
+volatile uint8_t _exitLock = 0;
+
+// Residency and wake source counts, awake time runs from _wakeSteps (the RTC
+// step the last sleep ended on) to the next sleep
+static SleepStats_t _sleepStats;
+static uint64_t     _wakeSteps = 0;
+
+// Drivers told about CPU clock changes, a slot is free when postChange is NULL
+typedef struct
+{
+    ClockNotifier_t preChange;
+    ClockNotifier_t postChange;
+    void *          ctx;
+} ClockNotifierSlot_t;
+
+static ClockNotifierSlot_t _clkNotifiers[CLOCK_NOTIFIERS_MAX];
+static ClockChangeStats_t  _clkChangeStats;
 
 void disableSleep()
 {
@@ -47,7 +70,7 @@ void exitSleep()
 
     if( _needExitSleep ) {
         initSysTick();
-        _sysExitSleepTime = micros();
+        anchorMonotonicClock();
 
         _needExitSleep = 0;
     }
@@ -55,11 +78,53 @@ void exitSleep()
     _exitLock = 0;
 }
 
+// The lowest numbered enabled interrupt pending, SysTick_IRQn for SysTick or
+// SLEEP_WAKE_UNKNOWN when nothing is
+static int8_t pendingWakeSource()
+{
+    uint32_t pending = NVIC->ISPR[0] & NVIC->ISER[0];
+
+    for( int8_t irq = 0; pending; irq++, pending >>= 1 )
+        if( pending & 1 ) return irq;
+    if( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk ) return SysTick_IRQn;
+    return SLEEP_WAKE_UNKNOWN;
+}
+
+static void recordSleep( SleepLevel_t level, uint64_t steps, int8_t source )
+{
+    SleepLevelStats_t *stats = &_sleepStats.level[level];
+    uint32_t           residency = 0xFFFFFFFF;
+
+    if( steps < residency ) residency = (uint32_t)steps;
+    if( !stats->entries || residency < stats->minSteps )
+        stats->minSteps = residency;
+    if( residency > stats->maxSteps ) stats->maxSteps = residency;
+    stats->totalSteps += steps;
+    stats->entries++;
+
+    if( source == SLEEP_WAKE_UNKNOWN )
+        _sleepStats.wakeUnknown++;
+    else if( source == SysTick_IRQn )
+        _sleepStats.wakeSysTick++;
+    else if( source < PERIPH_COUNT_IRQn )
+        _sleepStats.wakeIRQ[source]++;
+}
+
 void sleepCPU( SleepLevel_t level )
 {
-    _sysUpTimeAccum += micros() - _sysExitSleepTime;
+    SleepLevel_t allowed = allowedSleepLevel();
+    if( level > allowed ) level = allowed;
 
     if( _sleepEn ) {
+        uint32_t prim = __get_PRIMASK();
+        uint64_t start, end;
+        int8_t   source;
+
+        // Interrupts stay masked across the WFI, a pending one still wakes the
+        // CPU and can be identified before its handler runs
+        __disable_irq();
+        start = stepsRTC();
+        _sleepStats.awakeSteps += start - _wakeSteps;
 
         _needExitSleep = 1;
         if( level > PM_SLEEP_IDLE_APB_Val ) {
@@ -73,12 +138,90 @@ void sleepCPU( SleepLevel_t level )
 
         __WFI();
 
+        source = pendingWakeSource();
+        end = stepsRTC();
+        recordSleep( level, end - start, source );
+        _wakeSteps = end;
+
         exitSleep();
+        if( !prim ) __enable_irq();
+    }
+}
+
+// Calls preChange (may be NULL) with ctx before every CPU clock change and
+// postChange once the new SystemCoreClock is running, e.g. to finish sending
+// and then rewrite a baud rate. A driver is identified by its postChange and
+// ctx, registering it again returns the same slot. Returns the slot or -1 when
+// all CLOCK_NOTIFIERS_MAX are taken.
+int8_t registerClockNotifier( ClockNotifier_t preChange,
+                              ClockNotifier_t postChange, void *ctx )
+{
+    int8_t slot = -1;
+
+    if( postChange == NULL ) return -1;
+
+    ATOMIC_OPERATION( {
+        for( int8_t i = 0; i < CLOCK_NOTIFIERS_MAX; i++ ) {
+            ClockNotifierSlot_t *n = &_clkNotifiers[i];
+            if( n->postChange == postChange && n->ctx == ctx ) {
+                slot = i;
+                break;
+            }
+            if( n->postChange == NULL && slot == -1 ) slot = i;
+        }
+
+        if( slot != -1 ) {
+            _clkNotifiers[slot].preChange = preChange;
+            _clkNotifiers[slot].postChange = postChange;
+            _clkNotifiers[slot].ctx = ctx;
+        }
+    } )
+
+    return slot;
+}
+
+void unregisterClockNotifier( ClockNotifier_t postChange, void *ctx )
+{
+    ATOMIC_OPERATION( {
+        for( uint8_t i = 0; i < CLOCK_NOTIFIERS_MAX; i++ ) {
+            ClockNotifierSlot_t *n = &_clkNotifiers[i];
+            if( n->postChange == postChange && n->ctx == ctx )
+                memset( n, 0, sizeof( *n ) );
+        }
+    } )
+}
+
+void getClockChangeStats( ClockChangeStats_t *stats )
+{
+    ATOMIC_OPERATION( { *stats = _clkChangeStats; } )
+}
+
+void clearClockChangeStats()
+{
+    ATOMIC_OPERATION(
+        { memset( &_clkChangeStats, 0, sizeof( _clkChangeStats ) ); } )
+}
+
+// The notifiers run with interrupts as the caller left them, a Uart waiting
+// for its buffer to drain needs them enabled
+static void notifyClockChange( uint8_t post )
+{
+    for( uint8_t i = 0; i < CLOCK_NOTIFIERS_MAX; i++ ) {
+        ClockNotifierSlot_t n = _clkNotifiers[i];
+        if( n.postChange == NULL ) continue;
+        if( post )
+            n.postChange( n.ctx );
+        else if( n.preChange != NULL )
+            n.preChange( n.ctx );
     }
 }
 
 void changeCPUClk( CPUClkSrc_t src )
 {
+    uint64_t start = monotonicTicks();
+    uint32_t cost;
+
+    notifyClockChange( 0 );
     disableSysTick();
 
     if( src < cpu_clk_dfll48 ) {
@@ -108,11 +251,146 @@ void changeCPUClk( CPUClkSrc_t src )
     }
 
     // If we change the clock frequency the SysTick timer will need to be
-    // restarted
+    // restarted, and micros() needs the new ticks per microsecond
     initSysTick();
+    refreshClockReciprocals();
+    anchorMonotonicClock();
+    notifyClockChange( 1 );
+
+    cost = ( uint32_t )( monotonicTicks() - start );
+    ATOMIC_OPERATION( {
+        _clkChangeStats.switches++;
+        _clkChangeStats.totalTicks += cost;
+        _clkChangeStats.lastTicks = cost;
+        if( cost > _clkChangeStats.maxTicks ) _clkChangeStats.maxTicks = cost;
+    } )
 }
 
+// Microseconds spent awake, wrapping like micros()
 uint32_t getSysUpTime()
 {
-    return _sysUpTimeAccum;
+    uint64_t awake;
+
+    ATOMIC_OPERATION(
+        { awake = _sleepStats.awakeSteps + ( stepsRTC() - _wakeSteps ); } )
+
+    // 1000000 / 32768 == 15625 / 512
+    return ( uint32_t )( ( awake * 15625 ) >> 9 );
+}
+
+// Copies the sleep statistics, the awake time includes the time since the last
+// wake and the average residency of each level is filled in
+void getSleepStats( SleepStats_t *stats )
+{
+    ATOMIC_OPERATION( {
+        *stats = _sleepStats;
+        stats->awakeSteps += stepsRTC() - _wakeSteps;
+    } )
+
+    for( uint8_t i = 0; i <= _deep_sleep; i++ ) {
+        SleepLevelStats_t *level = &stats->level[i];
+        level->avgSteps =
+            level->entries ? ( uint32_t )( level->totalSteps / level->entries )
+                           : 0;
+    }
+}
+
+// Restarts the statistics from now
+void clearSleepStats()
+{
+    ATOMIC_OPERATION( {
+        memset( &_sleepStats, 0, sizeof( _sleepStats ) );
+        _wakeSteps = stepsRTC();
+    } )
+}
+
+// Per mille of the time since the statistics were cleared that the CPU was
+// awake
+uint16_t cpuDutyCycle()
+{
+    uint64_t awake, asleep;
+
+    getAwakeSleepSteps( &awake, &asleep );
+    if( awake + asleep == 0 ) return 1000;
+    return ( uint16_t )( ( awake * 1000 ) / ( awake + asleep ) );
+}
+
+// RTC steps spent awake and asleep at any level since the statistics were
+// cleared, without copying all of them
+void getAwakeSleepSteps( uint64_t *awake, uint64_t *asleep )
+{
+    uint64_t total = 0;
+
+    ATOMIC_OPERATION( {
+        *awake = _sleepStats.awakeSteps + ( stepsRTC() - _wakeSteps );
+        for( uint8_t i = 0; i <= _deep_sleep; i++ )
+            total += _sleepStats.level[i].totalSteps;
+    } )
+    *asleep = total;
+}
+
+// Keeps the CPU from sleeping deeper than level until it is released, e.g. a
+// peripheral clocked from GCLK0 holds _cpu_ahb_apb as GCLK0 stops in standby.
+// Holds are counted, each hold needs its own release.
+void holdSleepLevel( SleepLevel_t level )
+{
+    if( level >= _deep_sleep ) return;
+    ATOMIC_OPERATION( {
+        if( _sleepHolds[level] < 0xFF ) _sleepHolds[level]++;
+    } )
+}
+
+void releaseSleepLevel( SleepLevel_t level )
+{
+    if( level >= _deep_sleep ) return;
+    ATOMIC_OPERATION( {
+        if( _sleepHolds[level] ) _sleepHolds[level]--;
+    } )
+}
+
+// The deepest level sleepCPU() will go to with the current holds
+SleepLevel_t allowedSleepLevel()
+{
+    for( uint8_t level = _cpu; level < _deep_sleep; level++ ) {
+        if( _sleepHolds[level] ) return (SleepLevel_t)level;
+    }
+    return _deep_sleep;
+}
+
+// With the tickless idle enabled the main loop sleeps between calls to loop()
+void enableTicklessIdle()
+{
+    _ticklessEn = 1;
+}
+
+void disableTicklessIdle()
+{
+    _ticklessEn = 0;
+}
+
+// Sleeps as deep as the holds allow until an interrupt, unless hasWork reports
+// pending work. RTC alarms wake the CPU through their compare, EIC lines wake
+// it through WAKEUP, and standby is skipped when the next alarm is too close to
+// pay for restarting the clocks. Interrupts are masked from the work check to
+// the sleep so an interrupt in between still wakes the CPU. A begun Serial
+// port holds idle so it keeps receiving, see Uart::holdIdleForRX().
+void ticklessIdle( int ( *hasWork )() )
+{
+    if( !_ticklessEn || !_sleepEn ) return;
+
+    uint32_t prim = __get_PRIMASK();
+    __disable_irq();
+
+    if( !hasWork || !hasWork() ) {
+        SleepLevel_t level = allowedSleepLevel();
+        uint64_t     next = rtcNextAlarm();
+
+        if( level == _deep_sleep && next &&
+            next < stepsRTC() + SLEEP_MIN_STANDBY_STEPS )
+            level = _cpu_ahb_apb;
+
+        sleepCPU( level );
+    }
+
+    if( !prim ) __enable_irq();
 }
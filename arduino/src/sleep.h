@@ -19,9 +19,13 @@
 #define SLEEP_H_
 
 #include <stdint.h>
+#include "sam.h"
 
 #define PM_SLEEP_STANDBY_Val 0xFF
 
+// Closest RTC alarm, in RTC steps, the tickless idle still goes to standby for
+#define SLEEP_MIN_STANDBY_STEPS 32
+
 typedef enum
 {
     cpu_clk_oscm8 = 0x0,
@@ -39,6 +43,41 @@ typedef enum
     _deep_sleep
 } SleepLevel_t;
 
+// Wake source recorded when no enabled interrupt was pending after a sleep
+#define SLEEP_WAKE_UNKNOWN -2
+
+typedef struct
+{
+    uint32_t entries;
+    uint64_t totalSteps; // RTC steps spent at the level
+    uint32_t minSteps, maxSteps, avgSteps;
+} SleepLevelStats_t;
+
+// Indexed by SleepLevel_t, the wake source is the interrupt found pending when
+// the CPU woke
+typedef struct
+{
+    SleepLevelStats_t level[_deep_sleep + 1];
+    uint64_t          awakeSteps;
+    uint32_t          wakeIRQ[PERIPH_COUNT_IRQn];
+    uint32_t          wakeSysTick, wakeUnknown;
+} SleepStats_t;
+
+// Drivers whose rate registers are computed from the CPU clock (GCLK0), see
+// registerClockNotifier()
+#define CLOCK_NOTIFIERS_MAX 8
+
+typedef void ( *ClockNotifier_t )( void *ctx );
+
+// Cost of changeCPUClk() in monotonic ticks (48 MHz), from the first pre
+// change notifier to the end of the last post change notifier
+typedef struct
+{
+    uint32_t switches;
+    uint64_t totalTicks;
+    uint32_t lastTicks, maxTicks;
+} ClockChangeStats_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,6 +88,23 @@ void     disableSleep();
 void     enableSleep();
 void     exitSleep();
 uint32_t getSysUpTime();
+void     getSleepStats( SleepStats_t *stats );
+void     clearSleepStats();
+uint16_t cpuDutyCycle();
+void     getAwakeSleepSteps( uint64_t *awake, uint64_t *asleep );
+
+int8_t registerClockNotifier( ClockNotifier_t preChange,
+                              ClockNotifier_t postChange, void *ctx );
+void   unregisterClockNotifier( ClockNotifier_t postChange, void *ctx );
+void   getClockChangeStats( ClockChangeStats_t *stats );
+void   clearClockChangeStats();
+
+void         holdSleepLevel( SleepLevel_t level );
+void         releaseSleepLevel( SleepLevel_t level );
+SleepLevel_t allowedSleepLevel();
+void         enableTicklessIdle();
+void         disableTicklessIdle();
+void         ticklessIdle( int ( *hasWork )() );
 
 #ifdef __cplusplus
 }
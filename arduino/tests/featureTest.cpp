@@ -24,11 +24,22 @@ volatile uint8_t  bytesEIC[6];
 
 #define PRINT_BUFF_SIZE 2048
 #define TC_ISR_SAMPLE_CNT 10
+#define PULSE_TEST_PIN 13
 
 char              _printBuff[PRINT_BUFF_SIZE];
 volatile uint32_t _TCISRTimeStamps, _TCISRPrev;
 volatile uint8_t  _TCISRIndex = 0;
 volatile uint8_t  _NMIISRCntr = 0;
+volatile uint32_t _windowHits = 0;
+volatile uint32_t _dacRefills = 0;
+volatile uint32_t _acCrossings = 0;
+volatile uint32_t _pulseWidth = 0, _pulsePeriod = 0;
+volatile uint32_t _plannerMatches = 0;
+volatile uint32_t _eventOverruns = 0;
+volatile uint8_t  _alarmOrder[4];
+volatile uint8_t  _alarmsFired = 0;
+volatile uint8_t  _idleAlarm = 0;
+volatile uint32_t _calendarFired[2] = {0, 0};
 
 void testSPI();
 void testGPIO();
@@ -42,6 +53,28 @@ void testTCContinuous();
 void testAsyncCounter();
 void testEIC();
 void testAnalog();
+void testTriggeredAnalog();
+void testAnalogWindow();
+void testDACStream();
+void testComparator();
+void testPulseCapture();
+void testEdgeCapture();
+void testTimerPlanner();
+void testDualPWM();
+void testSoftPWM();
+void testTone();
+void testEventChannel();
+void testPulseCounter();
+void testRTCAlarms();
+void testTicklessIdle();
+void testTimeConversion();
+void testMonotonic();
+void testDebugCost();
+void testCalendar();
+void testRTCCalibration();
+void testSleepStats();
+void testGovernor();
+void testClockNotifiers();
 void focusDelayTest();
 void testProcessingSpeed();
 void testWDTClear();
@@ -71,6 +104,28 @@ void loop()
             case 'i': testSPI(); break;
             case 'p': testEIC(); break;
             case 'a': testAnalog(); break;
+            case 'b': testTriggeredAnalog(); break;
+            case 'n': testAnalogWindow(); break;
+            case 'o': testDACStream(); break;
+            case 'k': testComparator(); break;
+            case 'j': testPulseCapture(); break;
+            case 'x': testEdgeCapture(); break;
+            case 'y': testTimerPlanner(); break;
+            case 'h': testDualPWM(); break;
+            case 'v': testSoftPWM(); break;
+            case 'u': testTone(); break;
+            case 'l': testEventChannel(); break;
+            case '2': testPulseCounter(); break;
+            case '3': testRTCAlarms(); break;
+            case '4': testTicklessIdle(); break;
+            case '5': testTimeConversion(); break;
+            case '6': testMonotonic(); break;
+            case '7': testDebugCost(); break;
+            case '8': testCalendar(); break;
+            case '9': testRTCCalibration(); break;
+            case '0': testSleepStats(); break;
+            case 'G': testGovernor(); break;
+            case 'C': testClockNotifiers(); break;
             case 'f': focusDelayTest(); break;
             case 'q': testProcessingSpeed(); break;
             case 'm': testAsyncCounter(); break;
@@ -108,11 +163,866 @@ void testAnalog()
     Serial.println( Analog::readVCC() );
     Serial.println( Analog::readTemperature() );
 
+    // Both in one ADC session, VCC in mV and temperature in 0.01 C
+    int16_t vccMv;
+    int32_t tempCenti;
+    Analog::readVCCAndTemperature( &vccMv, &tempCenti );
+    uint8_t i = sprintf( _printBuff, "%d mV, %ld.%02ld C", vccMv,
+                         tempCenti / 100, abs( tempCenti % 100 ) );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    // Oversampled reads, full scale should read 2^n - 1 for each width
+    Serial.println( highPinDefault.readOversampled( ana_oversample_13bit ) );
+    Serial.println( highPinDefault.readOversampled( ana_oversample_16bit ) );
+    Serial.println(
+        Analog::getAccumulatedLatency( ana_accum_256, ana_clk_div_8 ) );
+
+    // Scan all analog pins, A1 - A4 are consecutive channels and should be
+    // converted in a single hardware scan
+    int32_t scanPins[] = {A0, A1, A2, A3, A4, A5};
+    int16_t scanResults[6];
+    if( Analog::readScan( scanPins, 6, scanResults ) == 6 ) {
+        for( uint8_t i = 0; i < 6; i++ ) Serial.println( scanResults[i] );
+    }
+    else
+        Serial.println( "Scan failed" );
+
     // Make a triangle wave
     for( uint16_t i = 0; i < 0x3FF; i++ ) highPinDefault.writeSingle( i );
     for( uint16_t i = 0x3FF; i > 0; i-- ) highPinDefault.writeSingle( i );
 }
 
+void testTriggeredAnalog()
+{
+    Analog           pin( A1 );
+    volatile int16_t buff[64];
+
+    // Timer match events at 1 kHz start each conversion, no CPU involvement
+    // until the buffer is full
+    Timer.begin( 500, false, tc_mode_16_bit, false, tc_event_mc0 );
+    if( pin.beginTriggered( Timer.getEventGenerator( tc_event_mc0 ), buff,
+                            64 ) != 0 ) {
+        Serial.println( "Triggered ADC failed to start" );
+        Timer.end();
+        return;
+    }
+
+    uint32_t start = millis();
+    while( !Analog::triggeredBatchReady() )
+        ;
+
+    // Should be ~64 ms
+    uint32_t elapsed = millis() - start;
+    Analog::endTriggered();
+    Timer.end();
+
+    uint8_t i = sprintf( _printBuff, "64 samples in %lu ms, first %d last %d",
+                         elapsed, buff[0], buff[63] );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void windowISR( int16_t result )
+{
+    _windowHits++;
+}
+
+// Samples A1 at 32 Hz while in deep sleep, the CPU should only wake on window
+// matches (and the RTC overflow once a second)
+void testAnalogWindow()
+{
+    Analog pin( A1 );
+
+    _windowHits = 0;
+    if( pin.armWindow( 2048, 0, ana_window_above, windowISR ) != 0 ) {
+        Serial.println( "Window failed to arm" );
+        return;
+    }
+
+    Serial.end();
+    delay( 5000 );
+    Analog::disarmWindow();
+    Serial.begin( 500000 );
+
+    uint8_t i = sprintf( _printBuff, "%lu window matches above mid scale",
+                         _windowHits );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+// Refill with a ramp so the output is a continuous saw tooth
+void dacRefill( volatile uint16_t *half, uint16_t len )
+{
+    static uint16_t level = 0;
+    for( uint16_t i = 0; i < len; i++ ) {
+        half[i] = level;
+        level = ( level + 8 ) & 0x3FF;
+    }
+    _dacRefills++;
+}
+
+// Streams a saw tooth at 8 kHz from each source for one second, the output on
+// A0 should be a clean ~62 Hz ramp
+void testDACStream()
+{
+    volatile uint16_t buff[64];
+    DACStream         stream( &Timer );
+    DACStreamMode_t   modes[] = {dac_stream_event, dac_stream_isr};
+
+    for( uint8_t m = 0; m < 2; m++ ) {
+        _dacRefills = 0;
+        dacRefill( buff, 64 );
+        stream.begin( 8000, buff, 64, dacRefill, modes[m] );
+        delay( 1000 );
+        stream.end();
+
+        // Should be ~250 refills
+        uint8_t i = sprintf( _printBuff, "mode %d: %lu refills, %lu underruns",
+                             m, _dacRefills, stream.getUnderruns() );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+    }
+}
+
+void comparatorISR()
+{
+    _acCrossings++;
+}
+
+// Compares A1 against VDD / 2 with hysteresis, crossings should be counted
+// while the CPU sleeps in standby
+void testComparator()
+{
+    AnalogComparator ac( 0 );
+
+    _acCrossings = 0;
+    if( ac.begin( A1, ac_neg_scaled_vdd ) != 0 ) {
+        Serial.println( "Comparator failed to start" );
+        return;
+    }
+
+    ac.setScaler( 31 );
+    ac.setHysteresis( true );
+    ac.setRunInStandby( true );
+    ac.attachInterrupt( comparatorISR, ac_int_toggle );
+
+    uint8_t i = sprintf( _printBuff, "A1 %s VDD / 2",
+                         ac.read() ? "above" : "below" );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    Serial.end();
+    delay( 5000 );
+    ac.end();
+    Serial.begin( 500000 );
+
+    i = sprintf( _printBuff, "%lu crossings", _acCrossings );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void pulseISR( uint32_t widthUs, uint32_t periodUs )
+{
+    _pulseWidth = widthUs;
+    _pulsePeriod = periodUs;
+}
+
+// Requires a jumper from pin 6 to PULSE_TEST_PIN, the 1 kHz 25% PWM should
+// measure as a 250 us pulse with a 1000 us period
+void testPulseCapture()
+{
+    Timer.beginPWM( 1000, 25 );
+
+    uint32_t width = pulseIn( PULSE_TEST_PIN, HIGH, 10000 );
+    uint8_t  i = sprintf( _printBuff, "pulseIn HIGH: %lu us", width );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    width = pulseIn( PULSE_TEST_PIN, LOW, 10000 );
+    i = sprintf( _printBuff, "pulseIn LOW: %lu us", width );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    _pulseWidth = 0;
+    _pulsePeriod = 0;
+    if( measurePulseAsync( PULSE_TEST_PIN, HIGH, pulseISR ) != 0 ) {
+        Serial.println( "Async capture failed to start" );
+        Timer.end();
+        return;
+    }
+    delay( 100 );
+    endPulseAsync();
+    Timer.end();
+
+    i = sprintf( _printBuff, "async: %lu us of %lu us", _pulseWidth,
+                 _pulsePeriod );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+// Requires a jumper from pin 6 to PULSE_TEST_PIN, a 2 ms burst of 10 kHz PWM
+// should decode as one frame of ~40 edges, 50 us apart
+void testEdgeCapture()
+{
+    volatile EdgeEvent_t ring[128];
+    EdgeEvent_t          frame[64];
+    EdgeCapture          capture( &Timer2 );
+
+    if( capture.begin( PULSE_TEST_PIN, ring, 128, 1000 ) != 0 ) {
+        Serial.println( "Edge capture failed to start" );
+        return;
+    }
+
+    Timer.beginPWM( 10000, 50 );
+    delay( 2 );
+    Timer.end();
+    delay( 5 );
+
+    int16_t cnt = capture.readFrame( frame, 64 );
+    uint8_t i = sprintf( _printBuff, "%d edges, %lu overflows", cnt,
+                         capture.getOverflows() );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    for( int16_t e = 1; e < cnt; e++ ) {
+        i = sprintf(
+            _printBuff, "%d: %lu us", frame[e].level,
+            capture.ticksToMicros( frame[e].ticks - frame[e - 1].ticks ) );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+    }
+
+    capture.end();
+}
+
+void plannerISR()
+{
+    _plannerMatches++;
+}
+
+// Sweeps toggle frequencies from 1 Hz to 24 MHz and prints the worst planner
+// error per decade, failing a decade where a plan misses the error the count
+// resolution allows, then checks a plan's match rate on the hardware
+void testTimerPlanner()
+{
+    TCPlan_t plan;
+    uint32_t decade = 1;
+    bool     pass = true;
+
+    while( decade <= 10000000 ) {
+        int32_t  worst = 0;
+        uint32_t worstFreq = 0;
+        bool     decadePass = true;
+
+        for( uint32_t f = decade; f < decade * 10 && f <= 24000000;
+             f += ( decade / 100 ) ? decade / 100 : 1 ) {
+            if( TimerCounter::planFrequency( f * 2, &plan ) != 0 ) {
+                uint8_t i = sprintf( _printBuff, "No plan for %lu Hz", f );
+                _printBuff[i] = 0;
+                Serial.println( _printBuff );
+                decadePass = false;
+                continue;
+            }
+
+            // Undivided in 32 bit mode the count always fits, so the lowest
+            // error is at most half a count of it (plus the ppm truncation)
+            uint64_t count = SystemCoreClock / ( f * 2ull );
+            int32_t  bound = ( int32_t )( 500000ull / count ) + 1;
+            int32_t  err = abs( plan.errorPpm );
+            if( err > bound ) decadePass = false;
+            if( err > worst ) {
+                worst = err;
+                worstFreq = f;
+            }
+        }
+
+        uint8_t i = sprintf( _printBuff, "%s %lu Hz: worst %ld ppm at %lu Hz",
+                             decadePass ? "PASS" : "FAIL", decade, worst,
+                             worstFreq );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+        pass = pass && decadePass;
+        decade *= 10;
+    }
+
+    // 440 Hz tone on the lowest power plan, the count over one second should
+    // be the achieved rate within the policy's error and a match either side
+    // for the start and stop
+    if( TimerCounter::planFrequency( 880, &plan, tc_plan_lowest_power,
+                                     tc_mode_16_bit ) != 0 ||
+        abs( plan.errorPpm ) > TC_PLAN_MAX_POWER_ERROR_PPM )
+        pass = false;
+    _plannerMatches = 0;
+    Timer.registerISR( plannerISR );
+    Timer.begin( plan, true, true );
+    delay( 1000 );
+    Timer.end();
+    Timer.deregisterISR();
+
+    int32_t expected = 880 + ( 880 * plan.errorPpm ) / 1000000;
+    bool    matchPass = abs( (int32_t)_plannerMatches - expected ) <= 1;
+    pass = pass && matchPass;
+
+    uint8_t i = sprintf( _printBuff, "%s pre %lu cc %lu: %lu Hz, %ld ppm, %lu",
+                         matchPass ? "PASS" : "FAIL", plan.prescaler, plan.cc,
+                         plan.achievedHz, plan.errorPpm, _plannerMatches );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+    Serial.println( pass ? "Planner PASS" : "Planner FAIL" );
+}
+
+// Requires a jumper from pin 6 to PULSE_TEST_PIN. Runs 16 bit PWM on both
+// outputs of Timer and measures WO[1] at 25% and 75% duty, then fades both.
+void testDualPWM()
+{
+    PWM      pwm( &Timer );
+    uint32_t freq = pwm.beginDual( 700, 16 );
+    uint16_t duties[] = {0x4000, 0xC000};
+
+    for( uint8_t d = 0; d < 2; d++ ) {
+        pwm.setDuty( 0, 0xFFFF - duties[d] );
+        pwm.setDuty( 1, duties[d] );
+        delay( 5 );
+
+        uint32_t width = pulseIn( PULSE_TEST_PIN, HIGH, 10000 );
+        uint8_t  i = sprintf( _printBuff, "%lu Hz, duty 0x%04X: %lu us", freq,
+                              duties[d], width );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+    }
+
+    for( uint32_t duty = 0; duty <= 0xFFFF; duty += 0x100 ) {
+        pwm.setDuty( 0, duty );
+        pwm.setDuty( 1, 0xFFFF - duty );
+        delay( 2 );
+    }
+
+    pwm.end();
+}
+
+// Requires a jumper from pin 6 to PULSE_TEST_PIN. Runs 500 Hz software PWM on
+// pins 2 - 7 from Timer1, pin 6 at 25% should measure 500 us wide.
+void testSoftPWM()
+{
+    SoftPWM soft( &Timer1 );
+    int8_t  probe = -1;
+
+    for( uint32_t pin = 2; pin <= 7; pin++ ) {
+        int8_t ch = soft.attach( pin, 0 );
+        if( pin == 6 ) probe = ch;
+    }
+
+    if( probe == -1 || soft.begin( 500, 1000 ) != 0 ) {
+        Serial.println( "Soft PWM failed to start" );
+        return;
+    }
+
+    // Spread the channels out with two sharing an edge
+    for( uint8_t ch = 0; ch < 6; ch++ )
+        soft.setDuty( ch, 100 + ch * 150, false );
+    soft.setDuty( probe, 250, false );
+    soft.setDuty( 0, 250, false );
+    soft.commit();
+    delay( 10 );
+
+    uint32_t width = pulseIn( PULSE_TEST_PIN, HIGH, 10000 );
+    uint8_t  i = sprintf( _printBuff, "Soft PWM 25%%: %lu us", width );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    soft.end();
+}
+
+void testTone()
+{
+    static const Note chirp[] = {{2000, 100}, {0, 50}, {2500, 150}};
+
+    // A sequence on one channel must not cut the tone on the other short
+    tone( 1, 1000, 1 );
+    playSequence( 0, chirp, 3 );
+
+    delay( 400 );
+    uint8_t i = sprintf( _printBuff, "Tone after 400 ms: seq %d, tone %d",
+                         toneActive( 0 ), toneActive( 1 ) );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    delay( 700 );
+    i = sprintf( _printBuff, "Tone after 1100 ms: seq %d, tone %d",
+                 toneActive( 0 ), toneActive( 1 ) );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    // Repeating sequences run until stopped
+    playSequence( 0, chirp, 3, true );
+    delay( 1000 );
+    if( toneActive( 0 ) ) Serial.println( "Tone repeat running" );
+    noTone( 0 );
+    if( !toneActive( 0 ) ) Serial.println( "Tone stopped" );
+}
+
+void eventOverrunISR( int8_t channel )
+{
+    _eventOverruns++;
+}
+
+void testEventChannel()
+{
+    EventChannel ev;
+
+    // Software events into a timer that is not running are never taken, the
+    // second one must be flagged as an overrun
+    if( ev.begin( EVENT_GEN_NONE, event_path_sync ) != 0 ||
+        ev.addUser( Timer1.getEventUser() ) != 0 ) {
+        Serial.println( "Event channel failed to start" );
+        return;
+    }
+    _eventOverruns = 0;
+    ev.attachOverrunInterrupt( eventOverrunISR );
+
+    ev.trigger();
+    ev.trigger();
+    delayMicroseconds( 10 );
+
+    uint8_t i = sprintf( _printBuff, "Event ch %d busy %d, overrun isr %lu",
+                         ev.getChannel(), ev.isBusy(), _eventOverruns );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    ev.end();
+    if( ev.getChannel() == -1 ) Serial.println( "Event channel released" );
+}
+
+void testPulseCounter()
+{
+    PulseCounter counter( &Timer2 );
+
+    if( counter.begin( PULSE_TEST_PIN, RISING ) != 0 ) {
+        Serial.println( "Pulse counter failed to start" );
+        return;
+    }
+
+    // About 1 kHz on pin 6, which is jumpered to the test pin. The prescaler
+    // only gets close, the count should match the achieved frequency. The
+    // source timer stops in standby so stay awake while counting.
+    uint32_t freq = Timer.beginDualPWM( 1000, 8 );
+    Timer.setPWMDuty( 1, 0x8000 );
+    disableSleep();
+    delay( 1000 );
+    enableSleep();
+    Timer.end();
+
+    uint32_t count = (uint32_t)counter.readPulseCount();
+    uint8_t  i = sprintf( _printBuff, "Pulse count 1 s at %lu Hz: %lu", freq,
+                          count );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    // Nothing is counted without pulses, the CPU sleeps through this delay
+    counter.clear();
+    delay( 500 );
+    if( counter.readPulseCount() == 0 ) Serial.println( "Pulse count cleared" );
+
+    counter.end();
+}
+
+void alarmISR( void *ctx )
+{
+    if( _alarmsFired < 4 ) _alarmOrder[_alarmsFired++] = (uint8_t)(uint32_t)ctx;
+}
+
+void testRTCAlarms()
+{
+    uint64_t now = stepsRTC();
+
+    // Set out of order, 1 is cancelled, and 4 is shorter than a millisecond
+    _alarmsFired = 0;
+    rtcAlarmAt( now + RTC_EXACT_MILLIS_TO_STEPS( 30ull ), alarmISR, (void *)3 );
+    int16_t id = rtcAlarmAt( now + RTC_EXACT_MILLIS_TO_STEPS( 10ull ),
+                             alarmISR, (void *)1 );
+    rtcAlarmAt( now + RTC_EXACT_MILLIS_TO_STEPS( 1500ull ), alarmISR,
+                (void *)2 );
+    rtcAlarmAt( now + 20, alarmISR, (void *)4 );
+    rtcAlarmCancel( id );
+
+    delay( 2000 );
+
+    uint8_t i = sprintf( _printBuff, "RTC alarms fired %d: %d %d %d",
+                         _alarmsFired, _alarmOrder[0], _alarmOrder[1],
+                         _alarmOrder[2] );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+    if( rtcAlarmCancel( id ) == -1 ) Serial.println( "Stale alarm rejected" );
+}
+
+void idleAlarmISR( void *ctx )
+{
+    _idleAlarm = 1;
+}
+
+void testTicklessIdle()
+{
+    // Nothing held once the serial port has finished sending
+    Serial.flush();
+    delay( 5 );
+    SleepLevel_t idle = allowedSleepLevel();
+
+    // A timer on the main clock keeps the CPU out of standby
+    Timer.begin( 1000, true );
+    SleepLevel_t running = allowedSleepLevel();
+    Timer.end();
+
+    uint8_t i = sprintf( _printBuff, "Sleep level idle %d, timer %d, after %d",
+                         idle, running, allowedSleepLevel() );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+    Serial.flush();
+
+    // Sleep until a 100 ms alarm, only the alarm should wake the CPU
+    uint32_t wakes = 0;
+    _idleAlarm = 0;
+    enableTicklessIdle();
+    rtcAlarmAt( stepsRTC() + RTC_EXACT_MILLIS_TO_STEPS( 100ull ), idleAlarmISR,
+                0 );
+    while( !_idleAlarm ) {
+        ticklessIdle( 0 );
+        wakes++;
+    }
+    disableTicklessIdle();
+
+    i = sprintf( _printBuff, "Tickless idle woke %lu times", wakes );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void testTimeConversion()
+{
+    // CPU ticks spent per call of each time function at every core clock, the
+    // empty loop overhead is removed
+    const uint8_t calls = 100;
+    uint32_t      cost[5][3];
+
+    Serial.end();
+    for( uint8_t i = 0; i < 5; i++ ) {
+        changeCPUClk( (CPUClkSrc_t)i );
+
+        uint64_t st = getCPUTicks();
+        for( uint8_t j = 0; j < calls; j++ ) __asm__ volatile( "" );
+        uint32_t overhead = ( uint32_t )( getCPUTicks() - st );
+
+        st = getCPUTicks();
+        for( uint8_t j = 0; j < calls; j++ ) micros();
+        cost[i][0] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+        st = getCPUTicks();
+        for( uint8_t j = 0; j < calls; j++ ) millis();
+        cost[i][1] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+        st = getCPUTicks();
+        for( uint8_t j = 0; j < calls; j++ ) delayMicroseconds( 0 );
+        cost[i][2] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+    }
+
+    changeCPUClk( cpu_clk_oscm8 );
+    Serial.begin( 500000 );
+    Serial.println( "CPU ticks per call\nCPU Freq | micros | millis | "
+                    "delayMicroseconds(0)" );
+    for( uint8_t i = 0; i < 5; i++ ) {
+        uint8_t freq = 48;
+        if( i < 4 ) freq = 8 >> i;
+        uint8_t j = sprintf( _printBuff, "%d MHz\t | %lu\t | %lu\t | %lu",
+                             freq, cost[i][0], cost[i][1], cost[i][2] );
+        _printBuff[j] = 0;
+        Serial.println( _printBuff );
+    }
+}
+
+void testMonotonic()
+{
+    uint32_t backwards = 0;
+    uint64_t prev, now;
+
+    Serial.flush();
+    delay( 5 );
+
+    // Back to back reads while awake must never decrease
+    prev = monotonicNanos();
+    for( uint16_t i = 0; i < 1000; i++ ) {
+        now = monotonicNanos();
+        if( now < prev ) backwards++;
+        prev = now;
+    }
+
+    // Across standby the clock should follow the RTC
+    uint64_t stSteps = stepsRTC();
+    uint64_t stNanos = monotonicNanos();
+    _idleAlarm = 0;
+    rtcAlarmAt( stSteps + RTC_EXACT_MILLIS_TO_STEPS( 100ull ), idleAlarmISR,
+                0 );
+    while( !_idleAlarm ) sleepCPU( _deep_sleep );
+    uint32_t rtcMicros = ( uint32_t )(
+        ( ( stepsRTC() - stSteps ) * 1000000 ) >> 15 );
+    uint32_t sleepMicros =
+        ( uint32_t )( ( monotonicNanos() - stNanos ) / 1000 );
+
+    // And across CPU clock changes
+    Serial.end();
+    prev = monotonicNanos();
+    for( uint8_t i = 0; i < 5; i++ ) {
+        changeCPUClk( (CPUClkSrc_t)i );
+        now = monotonicNanos();
+        if( now < prev ) backwards++;
+        prev = now;
+    }
+    changeCPUClk( cpu_clk_oscm8 );
+    Serial.begin( 500000 );
+
+    uint8_t i = sprintf( _printBuff,
+                         "Backwards steps %lu\nStandby RTC %lu us, monotonic "
+                         "%lu us",
+                         backwards, rtcMicros, sleepMicros );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void testDebugCost()
+{
+    // CPU ticks per call of the instrumented timing functions, build with
+    // each CORE_DEBUG_LEVEL to compare the bookkeeping cost
+    const uint8_t calls = 100;
+    uint32_t      cost[5];
+    uint64_t      st;
+
+    initWDT( wdt_8_s );
+    Serial.flush();
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) __asm__ volatile( "" );
+    uint32_t overhead = ( uint32_t )( getCPUTicks() - st );
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) stepsRTC();
+    cost[0] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) getCPUTicks();
+    cost[1] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) micros();
+    cost[2] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) delayCPUTicks( 0 );
+    cost[3] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+
+    st = getCPUTicks();
+    for( uint8_t j = 0; j < calls; j++ ) clearWDT();
+    cost[4] = ( ( uint32_t )( getCPUTicks() - st ) - overhead ) / calls;
+    endWDT();
+
+    uint8_t i = sprintf( _printBuff,
+                         "CORE_DEBUG_LEVEL %d, CPU ticks per call\nstepsRTC "
+                         "%lu, getCPUTicks %lu, micros %lu",
+                         CORE_DEBUG_LEVEL, cost[0], cost[1], cost[2] );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+    i = sprintf( _printBuff, "delayCPUTicks(0) %lu, clearWDT %lu", cost[3],
+                 cost[4] );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void calendarISR( void *ctx )
+{
+    _calendarFired[(uint32_t)ctx] = rtcEpoch();
+}
+
+void testCalendar()
+{
+    RTCDate_t date;
+
+    // 2023-11-14 22:13:20 UTC, a Tuesday
+    rtcSetEpoch( 1700000000ul );
+    rtcGetDate( &date );
+    uint8_t i = sprintf( _printBuff, "%04d-%02d-%02d %02d:%02d:%02d day %d",
+                         date.year, date.month, date.day, date.hour,
+                         date.minute, date.second, date.weekday );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+
+    // A one shot alarm in 2 s and a daily alarm 3 s into the current day
+    _calendarFired[0] = _calendarFired[1] = 0;
+    int8_t once = rtcCalendarAlarmAt( rtcEpoch() + 2, calendarISR, (void *)0 );
+    rtcEpochToDate( rtcEpoch() + 3, &date );
+    int8_t daily = rtcDailyAlarm( date.hour, date.minute, date.second,
+                                  calendarISR, (void *)1 );
+
+    uint32_t st = millis();
+    while( ( !_calendarFired[0] || !_calendarFired[1] ) &&
+           millis() - st < 5000 )
+        delay( 10 );
+    rtcCalendarAlarmCancel( daily );
+
+    i = sprintf( _printBuff,
+                 "Alarms %d and %d fired at %lu and %lu, expected %lu and %lu",
+                 once, daily, _calendarFired[0], _calendarFired[1],
+                 1700000002ul, 1700000003ul );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void testRTCCalibration()
+{
+    // Against the CPU clock, so only meaningful when the core clock has a
+    // better reference than the 32 kHz crystal
+    RTCCalibration cal;
+    int16_t        previous = getFreqCorrRTC();
+
+    for( uint8_t pass = 0; pass < 2; pass++ ) {
+        Serial.flush();
+        int8_t rtn = cal.measureCPUClock( 2 );
+        uint8_t i = sprintf( _printBuff,
+                             "Pass %d: %d, error %ld ppb, FREQCORR %d -> %d",
+                             pass, rtn, cal.getErrorPPB(), getFreqCorrRTC(),
+                             cal.getCorrection() );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+
+        // The second pass should measure close to zero error
+        cal.apply();
+    }
+
+    setFreqCorrRTC( previous );
+}
+
+void testSleepStats()
+{
+    SleepStats_t stats;
+
+    Serial.flush();
+    delay( 5 );
+    clearSleepStats();
+
+    // Standby through the RTC alarms of a delay, then idle until SysTick or
+    // the RTC overflow wake the CPU
+    delay( 200 );
+    for( uint8_t i = 0; i < 5; i++ ) sleepCPU( _cpu );
+
+    getSleepStats( &stats );
+    for( uint8_t lvl = 0; lvl <= _deep_sleep; lvl++ ) {
+        SleepLevelStats_t *l = &stats.level[lvl];
+        uint8_t            i = sprintf(
+            _printBuff, "Level %d: %lu entries, %lu steps, min %lu max %lu",
+            lvl, l->entries, ( uint32_t )( l->totalSteps ), l->minSteps,
+            l->maxSteps );
+        i += sprintf( _printBuff + i, " avg %lu", l->avgSteps );
+        _printBuff[i] = 0;
+        Serial.println( _printBuff );
+    }
+
+    // The most frequent wake source
+    int8_t   top = SLEEP_WAKE_UNKNOWN;
+    uint32_t topCount = stats.wakeUnknown;
+    if( stats.wakeSysTick > topCount ) {
+        top = SysTick_IRQn;
+        topCount = stats.wakeSysTick;
+    }
+    for( int8_t irq = 0; irq < PERIPH_COUNT_IRQn; irq++ ) {
+        if( stats.wakeIRQ[irq] > topCount ) {
+            top = irq;
+            topCount = stats.wakeIRQ[irq];
+        }
+    }
+
+    uint8_t i = sprintf( _printBuff,
+                         "Top wake IRQ %d (%lu times), RTC is %d, duty %u/1000",
+                         top, topCount, RTC_IRQn, cpuDutyCycle() );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void testGovernor()
+{
+    // Serial at 500k requests at least 8 MHz
+    CPUClkSrc_t minimum = minCPUClk();
+    CPUClkSrc_t up = governorDecide( governor_ondemand, cpu_clk_oscm8, 900,
+                                     minimum );
+    CPUClkSrc_t down = governorDecide( governor_ondemand, cpu_clk_dfll48, 100,
+                                       minimum );
+    CPUClkSrc_t held = governorDecide( governor_ondemand, cpu_clk_dfll48, 200,
+                                       minimum );
+
+    // Busy then idle under ondemand, the clock should go up then back down to
+    // the Serial minimum
+    Serial.flush();
+    enableGovernor( governor_ondemand );
+    uint32_t st = millis();
+    while( millis() - st < 500 ) governorUpdate();
+    CPUClkSrc_t busy = currentCPUClk();
+    st = millis();
+    while( millis() - st < 2000 ) {
+        delay( 50 );
+        governorUpdate();
+    }
+    CPUClkSrc_t idle = currentCPUClk();
+    disableGovernor();
+    changeCPUClk( cpu_clk_oscm8 );
+
+    uint8_t i = sprintf( _printBuff,
+                         "Min %d, decide up %d down %d held %d, busy %d "
+                         "idle %d",
+                         minimum, up, down, held, busy, idle );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+}
+
+void testClockNotifiers()
+{
+    ClockChangeStats_t stats;
+    uint32_t           cost[5];
+
+    // Serial is retimed by its notifier, every line should be readable
+    clearClockChangeStats();
+    for( uint8_t i = 0; i < 10; i++ ) {
+        changeCPUClk( ( i & 1 ) ? cpu_clk_oscm8 : cpu_clk_dfll48 );
+        getClockChangeStats( &stats );
+        uint8_t j = sprintf( _printBuff, "Serial at %lu Hz, switch %lu us",
+                             SystemCoreClock, stats.lastTicks / 48 );
+        _printBuff[j] = 0;
+        Serial.println( _printBuff );
+    }
+    getClockChangeStats( &stats );
+
+    // Cost of switching to each clock, 500k baud needs at least 8 MHz
+    Serial.end();
+    for( uint8_t i = 0; i < 5; i++ ) {
+        ClockChangeStats_t one;
+        changeCPUClk( (CPUClkSrc_t)i );
+        getClockChangeStats( &one );
+        cost[i] = one.lastTicks / 48;
+    }
+    changeCPUClk( cpu_clk_oscm8 );
+    Serial.begin( 500000 );
+
+    uint8_t i = sprintf( _printBuff,
+                         "%lu switches, avg %lu us, max %lu us\nCPU Freq | "
+                         "Switch us",
+                         stats.switches,
+                         ( uint32_t )( stats.totalTicks / stats.switches / 48 ),
+                         stats.maxTicks / 48 );
+    _printBuff[i] = 0;
+    Serial.println( _printBuff );
+    for( i = 0; i < 5; i++ ) {
+        uint8_t freq = 48;
+        if( i < 4 ) freq = 8 >> i;
+        uint8_t j = sprintf( _printBuff, "%d MHz\t | %lu", freq, cost[i] );
+        _printBuff[j] = 0;
+        Serial.println( _printBuff );
+    }
+}
+
 void EICISR()
 {
 #if defined( FLUME_GA_WS_BOARD )
@@ -0,0 +1,126 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// fastdiv.c checked against 128 bit division for the divisors the core uses:
+// the delay.c ticks per microsecond at each CPU clock (1, 2, 4, 8, 48) and
+// the /6 of the monotonic clock, plus a few odd ones at the ends of the range.
+
+#include <stdio.h>
+#include "fastdiv.h"
+
+#define RANDOM_VALUES 1000000
+
+static const uint32_t _divisors[] = {
+    1, 2, 4, 8, 48, 6, 3, 1000003, 0x80000001, 0xFFFFFFFF};
+
+static int      _failures;
+static uint64_t _seed = 0x9E3779B97F4A7C15ull;
+
+static void check( const char *name, int pass )
+{
+    printf( "%s: %s\n", pass ? "PASS" : "FAIL", name );
+    if( !pass ) _failures++;
+}
+
+// xorshift64, reproducible from run to run
+static uint64_t random64()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 7;
+    _seed ^= _seed << 17;
+    return _seed;
+}
+
+static int divides( const FastDiv_t *fd, uint32_t d, uint64_t n )
+{
+    uint64_t expected = ( uint64_t )( (unsigned __int128)n / d );
+    uint64_t q = fastDiv( fd, n );
+
+    if( q != expected )
+        printf( "  %llu / %lu: %llu, expected %llu\n", (unsigned long long)n,
+                (unsigned long)d, (unsigned long long)q,
+                (unsigned long long)expected );
+    return q == expected;
+}
+
+// Around 0, the divisor, 2^32 and 2^64, and the largest multiples of the
+// divisor where the rounding of the reciprocal matters most
+static void testEdges()
+{
+    int pass = 1;
+
+    for( unsigned i = 0; i < sizeof( _divisors ) / sizeof( _divisors[0] );
+         i++ ) {
+        uint32_t  d = _divisors[i];
+        uint64_t  top = UINT64_MAX / d * d;
+        FastDiv_t fd;
+        uint64_t  edges[] = {
+            0, 1, d - 1ull, d, d + 1ull, 2ull * d - 1,
+            UINT32_MAX, 1ull << 32, ( 1ull << 32 ) + 1, 1ull << 63,
+            top - d, top - 1, top, UINT64_MAX - 1, UINT64_MAX};
+
+        fastDivInit( &fd, d );
+        for( unsigned e = 0; e < sizeof( edges ) / sizeof( edges[0] ); e++ )
+            pass &= divides( &fd, d, edges[e] );
+    }
+    check( "edge values divide exactly", pass );
+}
+
+// Random values over the full range, and shifted down so small quotients are
+// covered too
+static void testRandom()
+{
+    int pass = 1;
+
+    for( unsigned i = 0; i < sizeof( _divisors ) / sizeof( _divisors[0] );
+         i++ ) {
+        uint32_t  d = _divisors[i];
+        FastDiv_t fd;
+
+        fastDivInit( &fd, d );
+        for( uint32_t r = 0; r < RANDOM_VALUES && pass; r++ ) {
+            uint64_t n = random64();
+            pass &= divides( &fd, d, n );
+            pass &= divides( &fd, d, n >> ( r & 63 ) );
+        }
+    }
+    check( "random values divide exactly", pass );
+}
+
+static void testMulHigh()
+{
+    int pass = 1;
+
+    for( uint32_t r = 0; r < RANDOM_VALUES && pass; r++ ) {
+        uint64_t a = random64(), b = random64();
+        uint64_t expected =
+            ( uint64_t )( ( (unsigned __int128)a * b ) >> 64 );
+        pass = mulHigh64( a, b ) == expected;
+    }
+    pass &= mulHigh64( UINT64_MAX, UINT64_MAX ) == UINT64_MAX - 1;
+    check( "mulHigh64 matches the 128 bit product", pass );
+}
+
+int main()
+{
+    testEdges();
+    testRandom();
+    testMulHigh();
+
+    return _failures ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Host simulation of rtcFreqCorrection() against a drifting 32 kHz crystal.
+// Each calibration counts the RTC over a reference interval with the current
+// correction programmed, like RTCCalibration does, and programs the result
+// clamped like setFreqCorrRTC(). The residual rate error after each step must
+// stay within what the unit size, the count quantization and the drift since
+// the last calibration allow.
+
+#include <math.h>
+#include <stdio.h>
+#include "RTC.h"
+
+// One FREQCORR unit changes the rate by 2^-20
+#define UNIT_PPM ( 1e6 / 1048576.0 )
+
+// Reference interval of each calibration, in seconds
+#define CAL_SECONDS 64
+
+// Half a unit of rounding, a step of count quantization and a step of
+// reference jitter
+#define RESIDUAL_MAX_PPM \
+    ( UNIT_PPM / 2 + 2e6 / ( (double)RTC_STEPS_PER_SEC * CAL_SECONDS ) )
+
+static uint32_t _seed = 1;
+static double   _phase;
+static int      _failures;
+
+// Deterministic jitter of -1, 0 or 1 steps on the reference edges
+static int jitter()
+{
+    _seed = _seed * 1103515245u + 12345u;
+    return (int)( ( _seed >> 16 ) % 3 ) - 1;
+}
+
+// Rate error of the crystal plus the programmed correction, in ppm
+static double residualPPM( double crystalPPM, int16_t units )
+{
+    return ( ( 1 + crystalPPM / 1e6 ) * ( 1 + units / 1048576.0 ) - 1 ) * 1e6;
+}
+
+static int16_t clampUnits( int16_t units )
+{
+    if( units > RTC_FREQCORR_MAX ) return RTC_FREQCORR_MAX;
+    if( units < -RTC_FREQCORR_MAX ) return -RTC_FREQCORR_MAX;
+    return units;
+}
+
+// Counts the RTC over one reference interval and returns the new correction.
+// The count carries its fractional phase from one interval to the next.
+static int16_t calibrate( double crystalPPM, int16_t units )
+{
+    uint64_t expected = (uint64_t)RTC_STEPS_PER_SEC * CAL_SECONDS;
+    double   steps = expected * ( 1 + residualPPM( crystalPPM, units ) / 1e6 );
+    uint64_t measured;
+
+    _phase += steps;
+    measured = (uint64_t)floor( _phase ) + jitter();
+    _phase -= floor( _phase );
+
+    return clampUnits( rtcFreqCorrection( units, measured, expected ) );
+}
+
+static void check( const char *name, int pass )
+{
+    printf( "%s: %s\n", pass ? "PASS" : "FAIL", name );
+    if( !pass ) _failures++;
+}
+
+// Counts past 2^53 overflowed the scaling, e.g. a 6000 s measureCPUClock()
+// at 48 MHz counts ~9.4e18. The correction must not depend on the scale.
+static void testLargeCounts()
+{
+    static const uint64_t scales[] = {
+        6000ull * 48000000ull, 6000ull * 48000000ull << 15,
+        ( 1ull << 63 ) / 1000001ull * 1000000ull, 0xFFFFFFFFFFFFFFFFull / 2};
+    static const int32_t ppms[] = {0, 50, -50, 120, -120};
+    int pass = 1;
+
+    for( unsigned s = 0; s < sizeof( scales ) / sizeof( scales[0] ); s++ ) {
+        for( unsigned p = 0; p < sizeof( ppms ) / sizeof( ppms[0] ); p++ ) {
+            uint64_t expected = scales[s];
+            uint64_t measured =
+                expected + ( int64_t )( expected / 1000000 ) * ppms[p];
+            int16_t units = rtcFreqCorrection( 0, measured, expected );
+            double  residual = residualPPM( ppms[p], units );
+
+            if( fabs( residual ) > UNIT_PPM ) {
+                printf( "  %+ld ppm at %llu: %d units, %+.3f ppm left\n",
+                        (long)ppms[p], (unsigned long long)expected, units,
+                        residual );
+                pass = 0;
+            }
+        }
+    }
+    check( "counts up to 2^64 scale without overflowing", pass );
+}
+
+// A fixed crystal error is cancelled by the first calibration, whatever the
+// correction programmed before it
+static void testFixedError()
+{
+    static const double errors[] = {0, 0.4, -0.6, 12.3, -37.9, 95.0, -118.2};
+    static const int16_t starts[] = {0, 40, -127};
+    int pass = 1;
+
+    for( unsigned e = 0; e < sizeof( errors ) / sizeof( errors[0] ); e++ ) {
+        for( unsigned s = 0; s < sizeof( starts ) / sizeof( starts[0] ); s++ ) {
+            int16_t units = calibrate( errors[e], starts[s] );
+            double  residual = residualPPM( errors[e], units );
+
+            if( fabs( residual ) > RESIDUAL_MAX_PPM ) {
+                printf( "  %+.1f ppm from %d: %d units, %+.3f ppm left\n",
+                        errors[e], starts[s], units, residual );
+                pass = 0;
+            }
+        }
+    }
+    check( "fixed crystal errors cancelled in one calibration", pass );
+}
+
+// Errors past the correction range end up at the limit on the right side
+static void testSaturation()
+{
+    int16_t fast = 0, slow = 0;
+
+    for( int i = 0; i < 3; i++ ) {
+        fast = calibrate( 400, fast );
+        slow = calibrate( -2500, slow );
+    }
+    check( "errors past the range saturate",
+           fast == -RTC_FREQCORR_MAX && slow == RTC_FREQCORR_MAX );
+}
+
+// The crystal follows a daily temperature swing of +-25 ppm around -40 ppm and
+// is calibrated every CAL_SECONDS. The residual may grow by the drift over one
+// interval on top of the calibration error.
+static void testDrift()
+{
+    const double period = 86400;
+    const double swing = 25;
+    const double maxDrift = 2 * M_PI * swing * CAL_SECONDS / period;
+    double       worst = 0;
+    int16_t      units = 0;
+
+    for( double t = 0; t < 2 * period; t += CAL_SECONDS ) {
+        double crystal = -40 + swing * sin( 2 * M_PI * t / period );
+        double next = -40 + swing * sin( 2 * M_PI * ( t + CAL_SECONDS ) /
+                                         period );
+
+        // The count covers the interval, use its mean error
+        units = calibrate( ( crystal + next ) / 2, units );
+        double residual = fabs( residualPPM( next, units ) );
+        if( residual > worst ) worst = residual;
+    }
+
+    printf( "  worst residual %.3f ppm, allowed %.3f ppm\n", worst,
+            RESIDUAL_MAX_PPM + maxDrift );
+    check( "drifting crystal tracked", worst <= RESIDUAL_MAX_PPM + maxDrift );
+}
+
+int main()
+{
+    testFixedError();
+    testSaturation();
+    testLargeCounts();
+    testDrift();
+
+    return _failures ? 1 : 0;
+}
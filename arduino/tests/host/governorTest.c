@@ -0,0 +1,187 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Host simulation of the CPU clock governor. governor.c is built unchanged
+// against stubs for the RTC and the clock switch, and a workload needing a
+// given number of MHz drives governorUpdate() one sample period at a time.
+// The busy share at a clock is the demand over the clock, saturating at 1.
+
+#include <stdio.h>
+#include "governor.h"
+
+uint32_t SystemCoreClock = 1000000;
+uint32_t hostPrimask = 0;
+
+static uint64_t _now, _awake, _asleep;
+static uint32_t _switches;
+static int      _failures;
+
+uint64_t stepsRTC()
+{
+    return _now;
+}
+
+void getAwakeSleepSteps( uint64_t *awake, uint64_t *asleep )
+{
+    *awake = _awake;
+    *asleep = _asleep;
+}
+
+void changeCPUClk( CPUClkSrc_t src )
+{
+    SystemCoreClock =
+        ( src == cpu_clk_dfll48 ) ? 48000000ul : 8000000ul >> src;
+    _switches++;
+}
+
+static uint32_t clockMHz()
+{
+    return SystemCoreClock / 1000000;
+}
+
+// Runs one sample period of a workload that needs demandMHz of CPU time
+static void runSample( double demandMHz )
+{
+    double   busy = demandMHz / clockMHz();
+    uint64_t steps;
+
+    if( busy > 1 ) busy = 1;
+    steps = (uint64_t)( busy * GOVERNOR_SAMPLE_STEPS );
+    _awake += steps;
+    _asleep += GOVERNOR_SAMPLE_STEPS - steps;
+    _now += GOVERNOR_SAMPLE_STEPS;
+    governorUpdate();
+}
+
+static void check( const char *name, int pass )
+{
+    printf( "%s: %s\n", pass ? "PASS" : "FAIL", name );
+    if( !pass ) _failures++;
+}
+
+// The next slower clock than mhz, or 0 at the slowest
+static uint32_t slowerMHz( uint32_t mhz )
+{
+    switch( mhz ) {
+        case 48: return 8;
+        case 8: return 4;
+        case 4: return 2;
+        case 2: return 1;
+        default: return 0;
+    }
+}
+
+// Under a steady load ondemand settles within a few samples on a clock that
+// isn't overloaded, stops there, and only stays above the slowest clock while
+// the load is over the down threshold or the next slower clock would be
+// overloaded
+static void testSteadyLoad()
+{
+    static const double demands[] = {0.05, 0.25, 0.7, 1.5, 2.5, 3.5,
+                                     5,    7,    12,  30,  38,  45};
+    int pass = 1;
+
+    for( unsigned d = 0; d < sizeof( demands ) / sizeof( demands[0] ); d++ ) {
+        for( int i = 0; i < 10; i++ ) runSample( demands[d] );
+
+        uint32_t mhz = clockMHz();
+        uint32_t before = _switches;
+        for( int i = 0; i < 50; i++ ) runSample( demands[d] );
+
+        uint32_t busy = (uint32_t)( demands[d] * 1000 / mhz );
+        uint32_t slower = slowerMHz( mhz );
+        int      ok = _switches == before && clockMHz() == mhz &&
+                 ( busy < GOVERNOR_UP_PERMILLE || mhz == 48 );
+        if( slower && busy <= GOVERNOR_DOWN_PERMILLE &&
+            demands[d] * 1000 / slower < GOVERNOR_UP_PERMILLE )
+            ok = 0;
+
+        printf( "  %5.2f MHz of work: %2lu MHz, %4lu per mille busy\n",
+                demands[d], (unsigned long)mhz, (unsigned long)busy );
+        if( !ok ) pass = 0;
+    }
+    check( "steady loads settle without switching back and forth", pass );
+}
+
+// A burst takes the clock straight to full speed on the next sample and an
+// idle CPU walks back down one clock per sample
+static void testBurst()
+{
+    int pass = 1;
+
+    for( int i = 0; i < 10; i++ ) runSample( 0.1 );
+    pass = pass && clockMHz() == 1;
+
+    runSample( 40 );
+    pass = pass && clockMHz() == 48;
+
+    static const uint32_t down[] = {8, 4, 2, 1};
+    for( unsigned i = 0; i < sizeof( down ) / sizeof( down[0] ); i++ ) {
+        runSample( 0 );
+        pass = pass && clockMHz() == down[i];
+    }
+    check( "burst goes to full speed, idle steps back down", pass );
+}
+
+// A driver's minimum holds the clock up under no load and is switched to
+// right away, the governor drops below it once it is released
+static void testMinimum()
+{
+    int pass = 1;
+
+    for( int i = 0; i < 10; i++ ) runSample( 0 );
+    requestMinCPUClk( cpu_clk_oscm4 );
+    pass = pass && clockMHz() == 4;
+    for( int i = 0; i < 10; i++ ) runSample( 0 );
+    pass = pass && clockMHz() == 4;
+
+    releaseMinCPUClk( cpu_clk_oscm4 );
+    for( int i = 0; i < 10; i++ ) runSample( 0 );
+    pass = pass && clockMHz() == 1;
+    check( "driver minimum respected and released", pass );
+}
+
+static void testFixedPolicies()
+{
+    int pass = 1;
+
+    enableGovernor( governor_performance );
+    for( int i = 0; i < 5; i++ ) runSample( 0 );
+    pass = pass && clockMHz() == 48;
+
+    requestMinCPUClk( cpu_clk_oscm2 );
+    enableGovernor( governor_powersave );
+    for( int i = 0; i < 5; i++ ) runSample( 40 );
+    pass = pass && clockMHz() == 2;
+    releaseMinCPUClk( cpu_clk_oscm2 );
+
+    check( "performance and powersave ignore the load", pass );
+    enableGovernor( governor_ondemand );
+}
+
+int main()
+{
+    enableGovernor( governor_ondemand );
+
+    testSteadyLoad();
+    testBurst();
+    testMinimum();
+    testFixedPolicies();
+
+    return _failures ? 1 : 0;
+}
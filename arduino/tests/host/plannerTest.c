@@ -0,0 +1,101 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Host run of the timer planner with the bounds of featureTest 'y'. TCPlan.c
+// is built unchanged, the main clock is passed in as the source.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "TCPlan.h"
+
+static int _failures;
+
+static void check( const char *name, int pass )
+{
+    printf( "%s: %s\n", pass ? "PASS" : "FAIL", name );
+    if( !pass ) _failures++;
+}
+
+// Every rate from 1 Hz to half the clock in 1% of decade steps. Undivided in
+// 32 bit mode the count always fits, so the lowest error is at most half a
+// count of it (plus the ppm truncation).
+static void testLowestError( uint32_t clockHz )
+{
+    TCPlan_t plan;
+    uint32_t decade = 1;
+    int      pass = 1;
+    char     name[64];
+
+    while( decade <= clockHz / 2 ) {
+        int32_t  worst = 0;
+        uint32_t worstFreq = 0;
+
+        for( uint32_t f = decade; f < decade * 10 && f <= clockHz / 2;
+             f += ( decade / 100 ) ? decade / 100 : 1 ) {
+            if( tcPlanFrequency( f * 2, &plan, tc_plan_lowest_error,
+                                 tc_mode_32_bit, clockHz, 1 ) != 0 ) {
+                printf( "  no plan for %lu Hz\n", (unsigned long)f );
+                pass = 0;
+                continue;
+            }
+
+            uint64_t count = clockHz / ( f * 2ull );
+            int32_t  bound = ( int32_t )( 500000ull / count ) + 1;
+            int32_t  err = abs( plan.errorPpm );
+            if( err > bound ) pass = 0;
+            if( err > worst ) {
+                worst = err;
+                worstFreq = f;
+            }
+        }
+
+        printf( "  %lu Hz: worst %ld ppm at %lu Hz\n", (unsigned long)decade,
+                (long)worst, (unsigned long)worstFreq );
+        decade *= 10;
+    }
+
+    snprintf( name, sizeof( name ),
+              "lowest error within half a count at %lu Hz",
+              (unsigned long)clockHz );
+    check( name, pass );
+}
+
+// The 440 Hz tone of featureTest 'y' on the lowest power plan
+static void testLowestPower()
+{
+    TCPlan_t plan;
+    int      pass;
+
+    pass = tcPlanFrequency( 880, &plan, tc_plan_lowest_power, tc_mode_16_bit,
+                            48000000, 1 ) == 0 &&
+           abs( plan.errorPpm ) <= TC_PLAN_MAX_POWER_ERROR_PPM;
+    printf( "  pre %lu cc %lu: %lu Hz, %ld ppm\n",
+            (unsigned long)plan.prescaler, (unsigned long)plan.cc,
+            (unsigned long)plan.achievedHz, (long)plan.errorPpm );
+    check( "lowest power 880 Hz within the policy's error", pass );
+}
+
+int main()
+{
+    testLowestError( 48000000 );
+    testLowestError( 8000000 );
+    testLowestError( 1000000 );
+    testLowestPower();
+
+    return _failures ? 1 : 0;
+}
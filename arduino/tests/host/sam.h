@@ -0,0 +1,50 @@
+/*
+  Written by Warren Woolsey
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Just enough of the device header for the hardware free sources built by the
+// host tests. Interrupt masking only tracks PRIMASK.
+
+#ifndef SAM_H_
+#define SAM_H_
+
+#include <stdint.h>
+
+#define PM_SLEEP_IDLE_CPU_Val 0x0
+#define PM_SLEEP_IDLE_AHB_Val 0x1
+#define PM_SLEEP_IDLE_APB_Val 0x2
+#define PERIPH_COUNT_IRQn 20
+
+extern uint32_t SystemCoreClock;
+extern uint32_t hostPrimask;
+
+static inline uint32_t __get_PRIMASK()
+{
+    return hostPrimask;
+}
+
+static inline void __disable_irq()
+{
+    hostPrimask = 1;
+}
+
+static inline void __enable_irq()
+{
+    hostPrimask = 0;
+}
+
+#endif /* SAM_H_ */
@@ -28,3 +28,7 @@ CMSIS_VER      ?= 5.0.1
 CMSIS_CORE_INCLUDE ?= CMSIS/Include
 # CMSIS_VER      ?= 5.4.0
 # CMSIS_CORE_INCLUDE ?= CMSIS/Core/Include
+
+### Core timing debug bookkeeping, see arduino/src/core_debug.h ###
+# 0: off, 1: inside flags and counters only, 2: full snapshots
+CORE_DEBUG_LEVEL ?= 2